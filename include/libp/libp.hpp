@@ -2,6 +2,16 @@
 #define LIBP_HPP_GUARD
 
 #include <libp/sets/interval.hpp>
+#include <libp/sets/interval_binary.hpp>
+#include <libp/sets/interval_charconv.hpp>
+#include <libp/sets/interval_expression.hpp>
+#include <libp/sets/interval_overlay.hpp>
+#include <libp/sets/interval_parallel.hpp>
+#include <libp/sets/interval_sampler.hpp>
+#include <libp/sets/interval_set.hpp>
+#include <libp/sets/interval_static.hpp>
+#include <libp/sets/interval_stream.hpp>
+#include <libp/sets/interval_view.hpp>
 
 #endif
 
@@ -0,0 +1,152 @@
+#ifndef LIBP_SETS_BOUNDARY_TRAITS_HPP_GUARD
+#define LIBP_SETS_BOUNDARY_TRAITS_HPP_GUARD
+
+#include <cmath>
+#include <concepts>
+#include <limits>
+#include <type_traits>
+
+namespace libp {
+
+    template<class Boundary>
+    struct boundary_traits {
+        // The values a boundary type uses for the infinities and NaN. By default these are the type's
+        // own, which conversions between such types preserve. Specialise boundary_traits for a type
+        // without them to pick sentinel values instead: sentinels must be ordered -inf < every finite
+        // value < inf, and are never combined with another boundary type's values without going
+        // through Interval's converting constructor, which maps one type's sentinels to the other's.
+        //
+        // A discrete type, such as Discrete<Integer>, holds only integers, and its intervals are stored
+        // half-open as [a, b), with (a turned into [a+1 and b] into b+1) when the union is built. Every
+        // operation then works on the same sets as it would on the integers, so that [1,2] and [3,4]
+        // merge into [1,5).
+        //
+        // A type bounded below has no value to spare for -inf, and negative_infinity() is instead its
+        // least value, an ordinary finite one. The line of such a type starts there closed, so
+        // complements include it and conversions leave it alone.
+
+        static constexpr bool native_sentinels = true;
+        static constexpr bool discrete = false;
+        static constexpr bool bounded_below = false;
+
+        static constexpr Boundary infinity(void) { return std::numeric_limits<Boundary>::infinity(); }
+        static constexpr Boundary negative_infinity(void) { return -std::numeric_limits<Boundary>::infinity(); }
+        static constexpr Boundary nan(void) { return std::numeric_limits<Boundary>::quiet_NaN(); }
+        static constexpr bool isnan(const Boundary& x) {
+            if (std::is_constant_evaluated()) { return !(x == x); }
+            return std::isnan(x);
+        }
+    };
+
+    template<std::integral Integer>
+    struct integral_boundary_traits {
+        // Sentinels taken from the ends of an integer type's range. Signed types lose their two lowest
+        // values and the greatest, with NaN the lowest, -inf the next and inf the greatest. Unsigned
+        // types are bounded below: 0 is their least value rather than -inf, and they lose their two
+        // greatest values to inf and NaN. Discrete<Integer> uses the same sentinels.
+
+        static constexpr bool native_sentinels = false;
+        static constexpr bool discrete = false;
+        static constexpr bool bounded_below = std::is_unsigned_v<Integer>;
+
+        static constexpr Integer infinity(void) {
+            return std::is_signed_v<Integer> ? std::numeric_limits<Integer>::max() : std::numeric_limits<Integer>::max() - 1;
+        }
+
+        static constexpr Integer negative_infinity(void) {
+            return std::is_signed_v<Integer> ? std::numeric_limits<Integer>::min() + 1 : 0;
+        }
+
+        static constexpr Integer nan(void) {
+            return std::is_signed_v<Integer> ? std::numeric_limits<Integer>::min() : std::numeric_limits<Integer>::max();
+        }
+
+        static constexpr bool isnan(const Integer& x) { return x == nan(); }
+    };
+
+    template<std::integral Integer>
+        requires (!std::same_as<Integer, bool>)
+    struct boundary_traits<Integer> : integral_boundary_traits<Integer> { };
+
+    template<std::integral Integer>
+    struct Discrete {
+        // An integer boundary for discrete unions, so that IntervalUnion<Discrete<int>> holds the
+        // integers in its intervals while IntervalUnion<int> holds intervals of the real line with
+        // integer ends. It converts to and from Integer implicitly, and compares as one.
+
+        Integer value = 0;
+
+        constexpr Discrete() = default;
+        constexpr Discrete(Integer value_in): value(value_in) { }
+
+        constexpr operator Integer() const { return value; }
+
+        constexpr Discrete& operator++() { ++value; return *this; }
+    };
+
+    template<std::integral Integer>
+    struct boundary_traits<Discrete<Integer>> {
+        using integer_traits = integral_boundary_traits<Integer>;
+
+        static constexpr bool native_sentinels = false;
+        static constexpr bool discrete = true;
+        static constexpr bool bounded_below = integer_traits::bounded_below;
+
+        static constexpr Discrete<Integer> infinity(void) { return integer_traits::infinity(); }
+        static constexpr Discrete<Integer> negative_infinity(void) { return integer_traits::negative_infinity(); }
+        static constexpr Discrete<Integer> nan(void) { return integer_traits::nan(); }
+        static constexpr bool isnan(const Discrete<Integer>& x) { return integer_traits::isnan(x.value); }
+    };
+
+    namespace detail {
+
+        template<class To, class From>
+        constexpr To convert_boundary(const From& x) {
+            // x as a To, with sentinels mapped to sentinels.
+            if constexpr (boundary_traits<To>::native_sentinels && boundary_traits<From>::native_sentinels) {
+                return To(x);
+            } else {
+                if (boundary_traits<From>::isnan(x)) { return boundary_traits<To>::nan(); }
+                if (x == boundary_traits<From>::infinity()) { return boundary_traits<To>::infinity(); }
+                if (!boundary_traits<From>::bounded_below && x == boundary_traits<From>::negative_infinity()) {
+                    return boundary_traits<To>::negative_infinity();
+                }
+                return To(x);
+            }
+        }
+
+        template<class Boundary>
+        constexpr bool isfinite_boundary(const Boundary& x) {
+            return x != boundary_traits<Boundary>::infinity() &&
+                (boundary_traits<Boundary>::bounded_below || x != boundary_traits<Boundary>::negative_infinity());
+        }
+
+        template<class Boundary>
+        constexpr bool contains_negative_infinity(const Boundary& left_value, bool left_closed) {
+            // Whether an interval with this left end holds -inf, which no interval of a type bounded
+            // below does.
+            return !boundary_traits<Boundary>::bounded_below && left_closed && left_value == boundary_traits<Boundary>::negative_infinity();
+        }
+
+        template<class Lhs, class Rhs>
+        inline constexpr bool mixable_boundaries = std::is_same_v<Lhs, Rhs> ||
+            (boundary_traits<Lhs>::native_sentinels && boundary_traits<Rhs>::native_sentinels);
+
+        template<class Lhs, class Rhs>
+        struct common_boundary {
+            // The boundary type of the result of a binary set operation, eager or not.
+            static_assert(
+                mixable_boundaries<Lhs, Rhs>,
+                "boundary types with sentinels only combine with their own type; convert one operand first"
+            );
+            using type = std::common_type_t<Lhs, Rhs>;
+        };
+
+        template<class Lhs, class Rhs>
+        using common_boundary_t = typename common_boundary<Lhs, Rhs>::type;
+
+    }
+
+}
+
+#endif
@@ -0,0 +1,314 @@
+#ifndef LIBP_SETS_DETAIL_INTERVAL_CONTAINS_HPP_GUARD
+#define LIBP_SETS_DETAIL_INTERVAL_CONTAINS_HPP_GUARD
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(LIBP_DISABLE_SIMD)
+    #define LIBP_X86_SIMD 1
+    #include <immintrin.h>
+#endif
+
+namespace libp { namespace detail {
+
+    template<class Boundary>
+    struct IntervalArrays {
+        // A read-only look at the structure-of-arrays layout of an IntervalUnion: the i-th interval runs
+        // from left_values[i] to right_values[i], and bit i of left_closed (right_closed) is set when its
+        // left (right) bracket is closed. Bit i lives in word i/64 at position i%64.
+        const Boundary* left_values;
+        const Boundary* right_values;
+        const std::uint64_t* left_closed;
+        const std::uint64_t* right_closed;
+        std::size_t size;
+
+        constexpr bool left_closed_at(std::size_t i) const { return (left_closed[i / 64] >> (i % 64)) & 1; }
+        constexpr bool right_closed_at(std::size_t i) const { return (right_closed[i / 64] >> (i % 64)) & 1; }
+    };
+
+    enum class SimdLevel { scalar, avx2, avx512 };
+
+    inline SimdLevel supported_simd_level(void) {
+        #ifdef LIBP_X86_SIMD
+            static const SimdLevel level = []() {
+                __builtin_cpu_init();
+                if (__builtin_cpu_supports("avx512f")) { return SimdLevel::avx512; }
+                if (__builtin_cpu_supports("avx2")) { return SimdLevel::avx2; }
+                return SimdLevel::scalar;
+            }();
+            return level;
+        #else
+            return SimdLevel::scalar;
+        #endif
+    }
+
+    template<class Boundary, class X>
+    std::size_t lower_bound_right(const IntervalArrays<Boundary>& a, const X& x) {
+        // Index of the first interval whose right value is not less than x, found with a branchless
+        // binary search so that the loop trip count depends only on a.size. Requires a.size != 0.
+        const Boundary* base = a.right_values;
+        std::size_t len = a.size;
+        while (len > 1) {
+            auto half = len / 2;
+            base = base[half] < x ? base + half : base;
+            len -= half;
+        }
+        return static_cast<std::size_t>(base - a.right_values) + (*base < x);
+    }
+
+    template<class Boundary, class X>
+    constexpr bool contains_at(const IntervalArrays<Boundary>& a, std::size_t i, const X& x) {
+        // Same bracket semantics as Interval::operator().
+        const auto& left_value = a.left_values[i];
+        const auto& right_value = a.right_values[i];
+        return (left_value < x && x < right_value) ||
+            (x == left_value && a.left_closed_at(i)) ||
+            (x == right_value && a.right_closed_at(i));
+    }
+
+    template<class Boundary, class X>
+    std::uint64_t contains_word_scalar(const IntervalArrays<Boundary>& a, const X* xs, std::size_t count) {
+        // Bit k of the result is set when xs[k] is in the union, for k < count <= 64.
+        std::uint64_t word = 0;
+        for (std::size_t k = 0; k != count; ++k) {
+            auto i = lower_bound_right(a, xs[k]);
+            word |= std::uint64_t(i != a.size && contains_at(a, i, xs[k])) << k;
+        }
+        return word;
+    }
+
+    #ifdef LIBP_X86_SIMD
+
+    // Each kernel runs the branchless binary search on a full register of points at once, gathering
+    // the probed right values, so that every lane's cache misses are in flight together. Lanes never
+    // diverge because the trip count depends only on the number of intervals. Points that do not fill
+    // a register fall through to the scalar kernel.
+
+    __attribute__((target("avx2")))
+    inline std::uint64_t contains_word_avx2(const IntervalArrays<double>& a, const double* xs, std::size_t count) {
+        const auto n = static_cast<long long>(a.size);
+        const auto* left_closed = reinterpret_cast<const long long*>(a.left_closed);
+        const auto* right_closed = reinterpret_cast<const long long*>(a.right_closed);
+        const __m256i one = _mm256_set1_epi64x(1);
+        const __m256i n_vec = _mm256_set1_epi64x(n);
+        std::uint64_t word = 0;
+        std::size_t k = 0;
+        for (; k + 4 <= count; k += 4) {
+            __m256d x = _mm256_loadu_pd(xs + k);
+            __m256i base = _mm256_setzero_si256();
+            for (auto len = n; len > 1; ) {
+                auto half = len / 2;
+                __m256i probe = _mm256_add_epi64(base, _mm256_set1_epi64x(half));
+                __m256d lt = _mm256_cmp_pd(_mm256_i64gather_pd(a.right_values, probe, 8), x, _CMP_LT_OQ);
+                base = _mm256_blendv_epi8(base, probe, _mm256_castpd_si256(lt));
+                len -= half;
+            }
+            __m256d lt = _mm256_cmp_pd(_mm256_i64gather_pd(a.right_values, base, 8), x, _CMP_LT_OQ);
+            __m256i i = _mm256_sub_epi64(base, _mm256_castpd_si256(lt));
+            __m256i past_end = _mm256_cmpeq_epi64(i, n_vec);
+            i = _mm256_blendv_epi8(i, base, past_end);
+
+            __m256d left_value = _mm256_i64gather_pd(a.left_values, i, 8);
+            __m256d right_value = _mm256_i64gather_pd(a.right_values, i, 8);
+            __m256i word_index = _mm256_srli_epi64(i, 6);
+            __m256i bit_index = _mm256_and_si256(i, _mm256_set1_epi64x(63));
+            __m256i lc = _mm256_and_si256(_mm256_srlv_epi64(_mm256_i64gather_epi64(left_closed, word_index, 8), bit_index), one);
+            __m256i rc = _mm256_and_si256(_mm256_srlv_epi64(_mm256_i64gather_epi64(right_closed, word_index, 8), bit_index), one);
+            __m256d lc_mask = _mm256_castsi256_pd(_mm256_cmpeq_epi64(lc, one));
+            __m256d rc_mask = _mm256_castsi256_pd(_mm256_cmpeq_epi64(rc, one));
+
+            __m256d inside = _mm256_and_pd(
+                _mm256_cmp_pd(left_value, x, _CMP_LT_OQ),
+                _mm256_cmp_pd(x, right_value, _CMP_LT_OQ)
+            );
+            inside = _mm256_or_pd(inside, _mm256_and_pd(_mm256_cmp_pd(x, left_value, _CMP_EQ_OQ), lc_mask));
+            inside = _mm256_or_pd(inside, _mm256_and_pd(_mm256_cmp_pd(x, right_value, _CMP_EQ_OQ), rc_mask));
+            inside = _mm256_andnot_pd(_mm256_castsi256_pd(past_end), inside);
+            word |= std::uint64_t(_mm256_movemask_pd(inside)) << k;
+        }
+        return k == count ? word : word | (contains_word_scalar(a, xs + k, count - k) << k);
+    }
+
+    __attribute__((target("avx2")))
+    inline std::uint64_t contains_word_avx2(const IntervalArrays<float>& a, const float* xs, std::size_t count) {
+        // Uses 32 bit indices, so the caller must ensure a.size fits in an int. The bracket bitsets are
+        // read as 32 bit words, which on x86 are the low and high halves of each 64 bit word.
+        const auto n = static_cast<int>(a.size);
+        const auto* left_closed = reinterpret_cast<const int*>(a.left_closed);
+        const auto* right_closed = reinterpret_cast<const int*>(a.right_closed);
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256i n_vec = _mm256_set1_epi32(n);
+        std::uint64_t word = 0;
+        std::size_t k = 0;
+        for (; k + 8 <= count; k += 8) {
+            __m256 x = _mm256_loadu_ps(xs + k);
+            __m256i base = _mm256_setzero_si256();
+            for (auto len = n; len > 1; ) {
+                auto half = len / 2;
+                __m256i probe = _mm256_add_epi32(base, _mm256_set1_epi32(half));
+                __m256 lt = _mm256_cmp_ps(_mm256_i32gather_ps(a.right_values, probe, 4), x, _CMP_LT_OQ);
+                base = _mm256_blendv_epi8(base, probe, _mm256_castps_si256(lt));
+                len -= half;
+            }
+            __m256 lt = _mm256_cmp_ps(_mm256_i32gather_ps(a.right_values, base, 4), x, _CMP_LT_OQ);
+            __m256i i = _mm256_sub_epi32(base, _mm256_castps_si256(lt));
+            __m256i past_end = _mm256_cmpeq_epi32(i, n_vec);
+            i = _mm256_blendv_epi8(i, base, past_end);
+
+            __m256 left_value = _mm256_i32gather_ps(a.left_values, i, 4);
+            __m256 right_value = _mm256_i32gather_ps(a.right_values, i, 4);
+            __m256i word_index = _mm256_srli_epi32(i, 5);
+            __m256i bit_index = _mm256_and_si256(i, _mm256_set1_epi32(31));
+            __m256i lc = _mm256_and_si256(_mm256_srlv_epi32(_mm256_i32gather_epi32(left_closed, word_index, 4), bit_index), one);
+            __m256i rc = _mm256_and_si256(_mm256_srlv_epi32(_mm256_i32gather_epi32(right_closed, word_index, 4), bit_index), one);
+            __m256 lc_mask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(lc, one));
+            __m256 rc_mask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(rc, one));
+
+            __m256 inside = _mm256_and_ps(
+                _mm256_cmp_ps(left_value, x, _CMP_LT_OQ),
+                _mm256_cmp_ps(x, right_value, _CMP_LT_OQ)
+            );
+            inside = _mm256_or_ps(inside, _mm256_and_ps(_mm256_cmp_ps(x, left_value, _CMP_EQ_OQ), lc_mask));
+            inside = _mm256_or_ps(inside, _mm256_and_ps(_mm256_cmp_ps(x, right_value, _CMP_EQ_OQ), rc_mask));
+            inside = _mm256_andnot_ps(_mm256_castsi256_ps(past_end), inside);
+            word |= std::uint64_t(_mm256_movemask_ps(inside)) << k;
+        }
+        return k == count ? word : word | (contains_word_scalar(a, xs + k, count - k) << k);
+    }
+
+    // GCC 12 warns that the AVX-512 intrinsics read the undefined registers they pass as merge
+    // sources; those lanes are never used, so the warning is silenced around these two kernels.
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+    __attribute__((target("avx512f")))
+    inline std::uint64_t contains_word_avx512(const IntervalArrays<double>& a, const double* xs, std::size_t count) {
+        const auto n = static_cast<long long>(a.size);
+        const __m512i one = _mm512_set1_epi64(1);
+        const __m512i n_vec = _mm512_set1_epi64(n);
+        const __m512i last = _mm512_set1_epi64(n - 1);
+        std::uint64_t word = 0;
+        std::size_t k = 0;
+        for (; k + 8 <= count; k += 8) {
+            __m512d x = _mm512_loadu_pd(xs + k);
+            __m512i base = _mm512_setzero_si512();
+            for (auto len = n; len > 1; ) {
+                auto half = len / 2;
+                __m512i probe = _mm512_add_epi64(base, _mm512_set1_epi64(half));
+                __mmask8 lt = _mm512_cmp_pd_mask(_mm512_i64gather_pd(probe, a.right_values, 8), x, _CMP_LT_OQ);
+                base = _mm512_mask_blend_epi64(lt, base, probe);
+                len -= half;
+            }
+            __mmask8 lt = _mm512_cmp_pd_mask(_mm512_i64gather_pd(base, a.right_values, 8), x, _CMP_LT_OQ);
+            __m512i i = _mm512_mask_add_epi64(base, lt, base, one);
+            __mmask8 valid = _mm512_cmpneq_epu64_mask(i, n_vec);
+            i = _mm512_min_epu64(i, last);
+
+            __m512d left_value = _mm512_i64gather_pd(i, a.left_values, 8);
+            __m512d right_value = _mm512_i64gather_pd(i, a.right_values, 8);
+            __m512i word_index = _mm512_srli_epi64(i, 6);
+            __m512i bit_index = _mm512_and_si512(i, _mm512_set1_epi64(63));
+            __mmask8 lc = _mm512_test_epi64_mask(_mm512_srlv_epi64(_mm512_i64gather_epi64(word_index, a.left_closed, 8), bit_index), one);
+            __mmask8 rc = _mm512_test_epi64_mask(_mm512_srlv_epi64(_mm512_i64gather_epi64(word_index, a.right_closed, 8), bit_index), one);
+
+            __mmask8 inside =
+                (_mm512_cmp_pd_mask(left_value, x, _CMP_LT_OQ) & _mm512_cmp_pd_mask(x, right_value, _CMP_LT_OQ)) |
+                (_mm512_cmp_pd_mask(x, left_value, _CMP_EQ_OQ) & lc) |
+                (_mm512_cmp_pd_mask(x, right_value, _CMP_EQ_OQ) & rc);
+            word |= std::uint64_t(inside & valid) << k;
+        }
+        return k == count ? word : word | (contains_word_scalar(a, xs + k, count - k) << k);
+    }
+
+    __attribute__((target("avx512f")))
+    inline std::uint64_t contains_word_avx512(const IntervalArrays<float>& a, const float* xs, std::size_t count) {
+        // Uses 32 bit indices and 32 bit bitset words, as in the AVX2 float kernel.
+        const auto n = static_cast<int>(a.size);
+        const __m512i one = _mm512_set1_epi32(1);
+        const __m512i n_vec = _mm512_set1_epi32(n);
+        const __m512i last = _mm512_set1_epi32(n - 1);
+        std::uint64_t word = 0;
+        std::size_t k = 0;
+        for (; k + 16 <= count; k += 16) {
+            __m512 x = _mm512_loadu_ps(xs + k);
+            __m512i base = _mm512_setzero_si512();
+            for (auto len = n; len > 1; ) {
+                auto half = len / 2;
+                __m512i probe = _mm512_add_epi32(base, _mm512_set1_epi32(half));
+                __mmask16 lt = _mm512_cmp_ps_mask(_mm512_i32gather_ps(probe, a.right_values, 4), x, _CMP_LT_OQ);
+                base = _mm512_mask_blend_epi32(lt, base, probe);
+                len -= half;
+            }
+            __mmask16 lt = _mm512_cmp_ps_mask(_mm512_i32gather_ps(base, a.right_values, 4), x, _CMP_LT_OQ);
+            __m512i i = _mm512_mask_add_epi32(base, lt, base, one);
+            __mmask16 valid = _mm512_cmpneq_epu32_mask(i, n_vec);
+            i = _mm512_min_epu32(i, last);
+
+            __m512 left_value = _mm512_i32gather_ps(i, a.left_values, 4);
+            __m512 right_value = _mm512_i32gather_ps(i, a.right_values, 4);
+            __m512i word_index = _mm512_srli_epi32(i, 5);
+            __m512i bit_index = _mm512_and_si512(i, _mm512_set1_epi32(31));
+            __mmask16 lc = _mm512_test_epi32_mask(_mm512_srlv_epi32(_mm512_i32gather_epi32(word_index, a.left_closed, 4), bit_index), one);
+            __mmask16 rc = _mm512_test_epi32_mask(_mm512_srlv_epi32(_mm512_i32gather_epi32(word_index, a.right_closed, 4), bit_index), one);
+
+            __mmask16 inside =
+                (_mm512_cmp_ps_mask(left_value, x, _CMP_LT_OQ) & _mm512_cmp_ps_mask(x, right_value, _CMP_LT_OQ)) |
+                (_mm512_cmp_ps_mask(x, left_value, _CMP_EQ_OQ) & lc) |
+                (_mm512_cmp_ps_mask(x, right_value, _CMP_EQ_OQ) & rc);
+            word |= std::uint64_t(inside & valid) << k;
+        }
+        return k == count ? word : word | (contains_word_scalar(a, xs + k, count - k) << k);
+    }
+
+    #pragma GCC diagnostic pop
+
+    #endif
+
+    template<class Boundary, class X>
+    std::uint64_t contains_word(const IntervalArrays<Boundary>& a, const X* xs, std::size_t count, SimdLevel level) {
+        // Bit k of the result is set when xs[k] is in the union, for k < count <= 64. The vector kernels
+        // are only used when the points and boundaries share a floating point type.
+        if (a.size == 0) { return 0; }
+        #ifdef LIBP_X86_SIMD
+            if constexpr (std::is_same_v<Boundary, X> && (std::is_same_v<X, double> || std::is_same_v<X, float>)) {
+                bool indices_fit = std::is_same_v<X, double> || a.size <= std::size_t(std::numeric_limits<int>::max());
+                if (level == SimdLevel::avx512 && indices_fit) { return contains_word_avx512(a, xs, count); }
+                if (level == SimdLevel::avx2 && indices_fit) { return contains_word_avx2(a, xs, count); }
+            }
+        #endif
+        return contains_word_scalar(a, xs, count);
+    }
+
+    template<class WordFn>
+    void write_contains_words(std::size_t count, std::uint64_t* bits, WordFn word) {
+        // Writes ceil(count/64) words, leaving the bits past count clear. word(k, chunk) returns the
+        // membership bits of points k to k + chunk - 1.
+        for (std::size_t k = 0; k < count; k += 64) {
+            bits[k / 64] = word(k, std::min<std::size_t>(64, count - k));
+        }
+    }
+
+    template<class WordFn>
+    void write_contains_words(std::size_t count, bool* mask, WordFn word) {
+        for (std::size_t k = 0; k < count; k += 64) {
+            auto chunk = std::min<std::size_t>(64, count - k);
+            auto bits = word(k, chunk);
+            for (std::size_t j = 0; j != chunk; ++j) {
+                mask[k + j] = (bits >> j) & 1;
+            }
+        }
+    }
+
+    template<class Boundary, class X, class Out>
+    void contains(const IntervalArrays<Boundary>& a, const X* xs, std::size_t count, Out* out, SimdLevel level) {
+        write_contains_words(count, out, [&](std::size_t k, std::size_t chunk) {
+            return contains_word(a, xs + k, chunk, level);
+        });
+    }
+
+}}
+
+#endif
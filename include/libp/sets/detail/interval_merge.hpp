@@ -0,0 +1,284 @@
+#ifndef LIBP_SETS_DETAIL_INTERVAL_MERGE_HPP_GUARD
+#define LIBP_SETS_DETAIL_INTERVAL_MERGE_HPP_GUARD
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include <libp/sets/boundary_traits.hpp>
+
+namespace libp { namespace detail {
+
+    // The merges below read intervals from any sorted sequence exposing size(), left_value(i),
+    // left_closed(i), right_value(i) and right_closed(i), which IntervalVector and IntervalArrays both
+    // do, and hand each result interval to an emit(left_value, left_closed, right_value, right_closed)
+    // callback, so the same loop serves freshly allocated results and in-place updates.
+
+    template<class Boundary>
+    struct Cut {
+        // A position between the real numbers: just before value, or just after it when after is set.
+        // A left boundary [v is the cut before v and (v the cut after v; a right boundary v) is the cut
+        // before v and v] the cut after v. An interval is the set of points between its two cuts, and
+        // cuts are totally ordered by value and then side, which turns every bracket tie-break into a
+        // single comparison.
+
+        Boundary value;
+        bool after;
+
+        template<class T>
+        static constexpr Cut left(const T& value, bool closed) { return {Boundary(value), !closed}; }
+
+        template<class T>
+        static constexpr Cut right(const T& value, bool closed) { return {Boundary(value), closed}; }
+
+        constexpr bool closed_as_left(void) const { return !after; }
+        constexpr bool closed_as_right(void) const { return after; }
+
+        friend constexpr bool operator<(const Cut& a, const Cut& b) {
+            return a.value < b.value || (a.value == b.value && !a.after && b.after);
+        }
+
+        friend constexpr bool operator==(const Cut& a, const Cut& b) {
+            return a.value == b.value && a.after == b.after;
+        }
+    };
+
+    template<class T>
+    struct cut_key_traits {
+        static constexpr bool enabled = false;
+    };
+
+    template<class T>
+        requires (std::is_floating_point_v<T> && std::numeric_limits<T>::is_iec559 && sizeof(T) == 4)
+    struct cut_key_traits<T> {
+        static constexpr bool enabled = true;
+        using bits_type = std::uint32_t;
+        using key_type = std::uint64_t;
+    };
+
+    #ifdef __SIZEOF_INT128__
+        template<class T>
+            requires (std::is_floating_point_v<T> && std::numeric_limits<T>::is_iec559 && sizeof(T) == 8)
+        struct cut_key_traits<T> {
+            static constexpr bool enabled = true;
+            using bits_type = std::uint64_t;
+            using key_type = unsigned __int128;
+        };
+    #endif
+
+    template<class T>
+    constexpr auto cut_key(const T& value, bool after) {
+        // The cut (value, after) as one unsigned integer ordered as cuts are, for IEEE types with a
+        // key type wide enough: the bits of value with every bit of a negative flipped and the sign
+        // bit of a positive set, so that they order as the values do, then shifted up a place to take
+        // after as the lowest bit. -0 is read as +0, which it equals. Worth it where a key is compared
+        // many times, as in a sort; a merge compares each boundary about once, and encoding both sides
+        // of every comparison costs more than the bracket tie-breaks it saves.
+        using bits_type = typename cut_key_traits<T>::bits_type;
+        using key_type = typename cut_key_traits<T>::key_type;
+        constexpr int sign_shift = 8*sizeof(bits_type) - 1;
+        bits_type bits = std::bit_cast<bits_type>(value == T(0) ? T(0) : value);
+        bits ^= (bits_type(0) - (bits >> sign_shift)) | (bits_type(1) << sign_shift);
+        return (key_type(bits) << 1) | key_type(after);
+    }
+
+    template<class S, class T>
+    constexpr bool precedes_left(const S& s, bool s_closed, const T& t, bool t_closed) {
+        // Is the left boundary (s, s_closed) strictly before the left boundary (t, t_closed)? At a
+        // shared value, '[' comes before '('.
+        return s < t || (s == t && s_closed && !t_closed);
+    }
+
+    template<class S, class T>
+    constexpr bool precedes_right(const S& s, bool s_closed, const T& t, bool t_closed) {
+        // Is the right boundary (s, s_closed) strictly before the right boundary (t, t_closed)? At a
+        // shared value, ')' comes before ']'.
+        return s < t || (s == t && !s_closed && t_closed);
+    }
+
+    template<class S, class T>
+    constexpr bool touches(const S& right_value, bool right_closed, const T& left_value, bool left_closed) {
+        // Given intervals I and J with J's left boundary no earlier than I's, do I's right boundary
+        // (right_value, right_closed) and J's left boundary (left_value, left_closed) leave no gap
+        // between I and J?
+        return left_value < right_value || (left_value == right_value && (right_closed || left_closed));
+    }
+
+    template<class S, class T>
+    constexpr bool ends_before(const S& right_value, bool right_closed, const T& left_value, bool left_closed) {
+        // Does an interval with right boundary (right_value, right_closed) lie wholly before an interval
+        // with left boundary (left_value, left_closed), sharing no point with it?
+        return right_value < left_value || (right_value == left_value && !(right_closed && left_closed));
+    }
+
+    template<class Lhs, class Rhs>
+    constexpr bool is_subset_sorted(const Lhs& lhs, const Rhs& rhs) {
+        // Is every interval of the canonical sequence lhs inside the canonical sequence rhs? The
+        // intervals of rhs are separated by gaps, so each lhs interval must lie inside a single rhs
+        // interval. Returns at the first lhs interval that does not.
+        const std::size_t n = lhs.size();
+        const std::size_t m = rhs.size();
+        std::size_t j = 0;
+        for (std::size_t i = 0; i != n; ++i) {
+            while (j != m && ends_before(rhs.right_value(j), rhs.right_closed(j), lhs.left_value(i), lhs.left_closed(i))) { ++j; }
+            if (
+                j == m ||
+                precedes_left(lhs.left_value(i), lhs.left_closed(i), rhs.left_value(j), rhs.left_closed(j)) ||
+                precedes_right(rhs.right_value(j), rhs.right_closed(j), lhs.right_value(i), lhs.right_closed(i))
+            ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template<class Lhs, class Rhs>
+    constexpr bool is_disjoint_sorted(const Lhs& lhs, const Rhs& rhs) {
+        // Do two canonical sequences share no point? Two intervals meet unless one ends before the
+        // other starts, and whichever ends before the other starts cannot meet anything after it.
+        const std::size_t n = lhs.size();
+        const std::size_t m = rhs.size();
+        std::size_t i = 0, j = 0;
+        while (i != n && j != m) {
+            if (ends_before(lhs.right_value(i), lhs.right_closed(i), rhs.left_value(j), rhs.left_closed(j))) {
+                ++i;
+            } else if (ends_before(rhs.right_value(j), rhs.right_closed(j), lhs.left_value(i), lhs.left_closed(i))) {
+                ++j;
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template<class Lhs, class Rhs, class Emit>
+    constexpr void intersect_sorted(const Lhs& lhs, const Rhs& rhs, Emit&& emit) {
+        // Emits the intersection of two canonical sequences in order. The output is canonical too: two
+        // consecutive pieces come either from different lhs intervals or from different rhs intervals,
+        // and so are separated by a gap in one of the inputs. Each step advances past at least one
+        // input interval and emits at most one piece.
+        const std::size_t n = lhs.size();
+        const std::size_t m = rhs.size();
+        std::size_t i = 0, j = 0;
+        while (i != n && j != m) {
+            // The intersection of the i-th lhs interval and the j-th rhs interval runs from the later of
+            // their left boundaries to the earlier of their right boundaries. Whichever interval ends
+            // first cannot meet any later interval of the other sequence.
+            bool lhs_left_later = precedes_left(rhs.left_value(j), rhs.left_closed(j), lhs.left_value(i), lhs.left_closed(i));
+            bool lhs_right_earlier = precedes_right(lhs.right_value(i), lhs.right_closed(i), rhs.right_value(j), rhs.right_closed(j));
+            bool rhs_right_earlier = precedes_right(rhs.right_value(j), rhs.right_closed(j), lhs.right_value(i), lhs.right_closed(i));
+            bool left_closed = lhs_left_later ? lhs.left_closed(i) : rhs.left_closed(j);
+            bool right_closed = lhs_right_earlier ? lhs.right_closed(i) : rhs.right_closed(j);
+            const auto& left_value = lhs_left_later ? lhs.left_value(i) : rhs.left_value(j);
+            const auto& right_value = lhs_right_earlier ? lhs.right_value(i) : rhs.right_value(j);
+            if (left_value < right_value || (left_value == right_value && left_closed && right_closed)) {
+                emit(left_value, left_closed, right_value, right_closed);
+            }
+            if (!rhs_right_earlier) { ++i; }
+            if (!lhs_right_earlier) { ++j; }
+        }
+    }
+
+    template<class Lhs, class Rhs, class Emit>
+    constexpr void merge_sorted(const Lhs& lhs, const Rhs& rhs, Emit&& emit) {
+        // Emits every interval of both sorted sequences in order of left boundary, taking lhs first on
+        // ties. The output overlaps wherever the inputs do, so emit is expected to coalesce.
+        const std::size_t n = lhs.size();
+        const std::size_t m = rhs.size();
+        std::size_t i = 0, j = 0;
+        while (i != n && j != m) {
+            if (!precedes_left(rhs.left_value(j), rhs.left_closed(j), lhs.left_value(i), lhs.left_closed(i))) {
+                emit(lhs.left_value(i), lhs.left_closed(i), lhs.right_value(i), lhs.right_closed(i));
+                ++i;
+            } else {
+                emit(rhs.left_value(j), rhs.left_closed(j), rhs.right_value(j), rhs.right_closed(j));
+                ++j;
+            }
+        }
+        for (; i != n; ++i) {
+            emit(lhs.left_value(i), lhs.left_closed(i), lhs.right_value(i), lhs.right_closed(i));
+        }
+        for (; j != m; ++j) {
+            emit(rhs.left_value(j), rhs.left_closed(j), rhs.right_value(j), rhs.right_closed(j));
+        }
+    }
+
+    template<class Intervals>
+    class OffsetIntervals {
+        // The intervals of a sequence from position offset onwards, renumbered from 0.
+
+        public:
+            constexpr OffsetIntervals(const Intervals& intervals_in, std::size_t offset_in, std::size_t size_in):
+                intervals(intervals_in),
+                offset(offset_in),
+                count(size_in)
+            { }
+
+            constexpr std::size_t size(void) const { return count; }
+            constexpr decltype(auto) left_value(std::size_t i) const { return intervals.left_value(offset + i); }
+            constexpr decltype(auto) right_value(std::size_t i) const { return intervals.right_value(offset + i); }
+            constexpr bool left_closed(std::size_t i) const { return intervals.left_closed(offset + i); }
+            constexpr bool right_closed(std::size_t i) const { return intervals.right_closed(offset + i); }
+
+        private:
+            const Intervals& intervals;
+            std::size_t offset;
+            std::size_t count;
+    };
+
+    template<class Intervals, class Boundary>
+    class ComplementIntervals {
+        // The complement of a canonical, non-NaN sequence, computed on demand with the same brackets as
+        // IntervalUnion::inv(extended_real_line). Gap t lies between intervals t-1 and t, with gap 0
+        // starting at -inf and gap n ending at +inf. The end gaps are dropped when they are empty. For
+        // a type bounded below, gap 0 starts at its least value and holds it whatever the line.
+
+        public:
+            constexpr ComplementIntervals(const Intervals& intervals_in, bool extended_real_line_in):
+                intervals(intervals_in),
+                n(intervals_in.size()),
+                extended_real_line(extended_real_line_in),
+                first_closed(extended_real_line_in || boundary_traits<Boundary>::bounded_below)
+            {
+                has_first = n == 0 || boundary_traits<Boundary>::negative_infinity() < intervals.left_value(0) || (first_closed && !intervals.left_closed(0));
+                has_last = n == 0 || intervals.right_value(n-1) < boundary_traits<Boundary>::infinity() || (extended_real_line && !intervals.right_closed(n-1));
+            }
+
+            constexpr std::size_t size(void) const { return n + 1 - !has_first - !has_last; }
+
+            constexpr Boundary left_value(std::size_t j) const {
+                auto t = gap(j);
+                return t == 0 ? Boundary(boundary_traits<Boundary>::negative_infinity()) : Boundary(intervals.right_value(t-1));
+            }
+
+            constexpr bool left_closed(std::size_t j) const {
+                auto t = gap(j);
+                return t == 0 ? first_closed : !intervals.right_closed(t-1);
+            }
+
+            constexpr Boundary right_value(std::size_t j) const {
+                auto t = gap(j);
+                return t == n ? Boundary(boundary_traits<Boundary>::infinity()) : Boundary(intervals.left_value(t));
+            }
+
+            constexpr bool right_closed(std::size_t j) const {
+                auto t = gap(j);
+                return t == n ? extended_real_line : !intervals.left_closed(t);
+            }
+
+        private:
+            const Intervals& intervals;
+            std::size_t n;
+            bool extended_real_line;
+            bool first_closed;
+            bool has_first;
+            bool has_last;
+
+            constexpr std::size_t gap(std::size_t j) const { return has_first ? j : j + 1; }
+    };
+
+}}
+
+#endif
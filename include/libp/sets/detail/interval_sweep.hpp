@@ -0,0 +1,91 @@
+#ifndef LIBP_SETS_DETAIL_INTERVAL_SWEEP_HPP_GUARD
+#define LIBP_SETS_DETAIL_INTERVAL_SWEEP_HPP_GUARD
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <libp/sets/detail/interval_merge.hpp>
+
+namespace libp { namespace detail {
+
+    // Sweeps over many canonical interval sequences at once. Every sequence contributes its boundaries
+    // as cuts, each sequence's cuts are already in order, and a heap holding the next cut of every
+    // sequence yields all of them in order in O(total log k) for k sequences.
+
+    template<class Boundary>
+    struct SweepCursor {
+        Cut<Boundary> cut;
+        std::size_t input;
+        std::size_t boundary; // 2i for the left boundary of interval i and 2i+1 for its right boundary
+    };
+
+    template<class Boundary, class Intervals>
+    Cut<Boundary> sweep_cut(const Intervals& intervals, std::size_t boundary) {
+        std::size_t i = boundary / 2;
+        return boundary % 2 == 0
+            ? Cut<Boundary>::left(intervals.left_value(i), intervals.left_closed(i))
+            : Cut<Boundary>::right(intervals.right_value(i), intervals.right_closed(i));
+    }
+
+    template<class Boundary, class Intervals, class Visit>
+    void sweep_cuts(const std::vector<const Intervals*>& inputs, Visit&& visit) {
+        // Calls visit(cut, changes) once for every distinct cut, in order, where changes lists an
+        // (input, entering) pair for every input with a boundary at that cut: entering is true for a
+        // left boundary and false for a right one. An input enters and leaves at distinct cuts, since
+        // its intervals are unempty and never touch, so it appears at most once in changes.
+        auto later = [](const SweepCursor<Boundary>& a, const SweepCursor<Boundary>& b) {
+            return b.cut < a.cut || (b.cut == a.cut && b.input < a.input);
+        };
+        std::vector<SweepCursor<Boundary>> heap; heap.reserve(inputs.size());
+        for (std::size_t input = 0; input != inputs.size(); ++input) {
+            if (inputs[input]->size() != 0) {
+                heap.push_back({sweep_cut<Boundary>(*inputs[input], 0), input, 0});
+            }
+        }
+        std::make_heap(heap.begin(), heap.end(), later);
+        std::vector<std::pair<std::size_t, bool>> changes; changes.reserve(inputs.size());
+        while (!heap.empty()) {
+            const Cut<Boundary> cut = heap.front().cut;
+            changes.clear();
+            while (!heap.empty() && heap.front().cut == cut) {
+                std::pop_heap(heap.begin(), heap.end(), later);
+                auto& cursor = heap.back();
+                changes.emplace_back(cursor.input, cursor.boundary % 2 == 0);
+                const auto& intervals = *inputs[cursor.input];
+                if (++cursor.boundary != 2*intervals.size()) {
+                    cursor.cut = sweep_cut<Boundary>(intervals, cursor.boundary);
+                    std::push_heap(heap.begin(), heap.end(), later);
+                } else {
+                    heap.pop_back();
+                }
+            }
+            visit(cut, changes);
+        }
+    }
+
+    template<class Boundary, class Intervals, class Emit>
+    void covered_by_at_least(const std::vector<const Intervals*>& inputs, std::size_t k, Emit&& emit) {
+        // Emits, in order, the maximal pieces covered by at least k != 0 of the inputs. Since all the
+        // boundaries at one cut are applied together, a piece starts at the cut where the count of
+        // covering inputs reaches k and ends at the next cut where it falls below k, so consecutive
+        // pieces are separated by a gap and the output is canonical.
+        std::size_t covering = 0;
+        Cut<Boundary> start{};
+        sweep_cuts<Boundary>(inputs, [&](const Cut<Boundary>& cut, const auto& changes) {
+            bool was_covered = covering >= k;
+            for (const auto& change : changes) {
+                if (change.second) { ++covering; } else { --covering; }
+            }
+            if (!was_covered && covering >= k) {
+                start = cut;
+            } else if (was_covered && covering < k) {
+                emit(start.value, start.closed_as_left(), cut.value, cut.closed_as_right());
+            }
+        });
+    }
+
+}}
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef LIBP_SETS_DETAIL_PARALLEL_HPP_GUARD
+#define LIBP_SETS_DETAIL_PARALLEL_HPP_GUARD
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace libp { namespace detail {
+
+    inline std::size_t thread_count(unsigned requested) {
+        // The number of threads to use when requested of them are asked for, where 0 asks for one per
+        // hardware thread.
+        if (requested != 0) { return requested; }
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    template<class Task>
+    void parallel_for(std::size_t tasks, Task&& task) {
+        // Calls task(0), ..., task(tasks - 1) concurrently, running the last on the calling thread, and
+        // returns once all of them have. Tasks for which no thread can be started run on the calling
+        // thread too. Rethrows the exception of the lowest-numbered task that threw.
+        std::vector<std::exception_ptr> errors(tasks);
+        auto run = [&](std::size_t t) {
+            try { task(t); } catch (...) { errors[t] = std::current_exception(); }
+        };
+        std::vector<std::thread> threads; threads.reserve(tasks == 0 ? 0 : tasks - 1);
+        std::size_t started = 0;
+        try {
+            for (; started + 1 < tasks; ++started) { threads.emplace_back(run, started); }
+        } catch (const std::system_error&) { }
+        for (std::size_t t = started; t < tasks; ++t) { run(t); }
+        for (auto& thread : threads) { thread.join(); }
+        for (const auto& error : errors) {
+            if (error) { std::rethrow_exception(error); }
+        }
+    }
+
+}}
+
+#endif
@@ -0,0 +1,205 @@
+#ifndef LIBP_SETS_DETAIL_SEARCH_INDEX_HPP_GUARD
+#define LIBP_SETS_DETAIL_SEARCH_INDEX_HPP_GUARD
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include <libp/sets/detail/interval_contains.hpp>
+
+namespace libp { namespace detail {
+
+    template<class Boundary>
+    class EytzingerIndex {
+        // The intervals of an IntervalUnion laid out in breadth-first (Eytzinger) order of their right
+        // values, so that the first few levels of every search share a handful of cache lines and the
+        // nodes probed three or four levels further down sit in a single cache line that can be
+        // prefetched while the current comparison resolves. Node k has children 2k and 2k+1 and node 0
+        // is unused. Left values and brackets are stored in the same order, so a lookup ends at the node
+        // it found instead of chasing a sorted position back into the union's own arrays.
+
+        public:
+            explicit EytzingerIndex(const IntervalArrays<Boundary>& a):
+                n(a.size),
+                storage(a.size + 1 + line_keys),
+                left_values(a.size + 1),
+                brackets(a.size + 1)
+            {
+                // Offset keys so that keys[0] starts a cache line whenever the boundary size allows it.
+                auto address = reinterpret_cast<std::uintptr_t>(storage.data());
+                std::size_t offset = 0;
+                if (64 % sizeof(Boundary) == 0) {
+                    offset = ((64 - address % 64) % 64) / sizeof(Boundary);
+                }
+                keys = storage.data() + offset;
+
+                std::size_t i = 0;
+                build(a, i, 1);
+            }
+
+            template<class X>
+            std::size_t lower_bound(const X& x) const {
+                // Node holding the first right value that is not less than x, or 0 if there is none.
+                std::size_t k = 1;
+                while (k <= n) {
+                    prefetch(k);
+                    k = 2*k + (keys[k] < x);
+                }
+                return k >> (std::countr_one(k) + 1);
+            }
+
+            template<class X>
+            void lower_bound(const X* xs, std::size_t count, std::size_t* out) const {
+                // Batched lower_bound. Descends for a group of points at a time, one level per pass, so
+                // that the group's cache misses are outstanding together. The top depth levels exist for
+                // every search, and the last level only for those that land at k <= n.
+                const std::size_t depth = std::bit_width(n) - 1;
+                constexpr std::size_t group = 16;
+                std::size_t k[group];
+                for (std::size_t first = 0; first < count; first += group) {
+                    const auto g = std::min(group, count - first);
+                    for (std::size_t j = 0; j != g; ++j) { k[j] = 1; }
+                    for (std::size_t level = 0; level != depth; ++level) {
+                        for (std::size_t j = 0; j != g; ++j) {
+                            prefetch(k[j]);
+                            k[j] = 2*k[j] + (keys[k[j]] < xs[first + j]);
+                        }
+                    }
+                    for (std::size_t j = 0; j != g; ++j) {
+                        if (k[j] <= n) { k[j] = 2*k[j] + (keys[k[j]] < xs[first + j]); }
+                        out[first + j] = k[j] >> (std::countr_one(k[j]) + 1);
+                    }
+                }
+            }
+
+            template<class X>
+            bool contains_at(std::size_t k, const X& x) const {
+                // Whether the interval at node k contains x, with the bracket semantics of
+                // Interval::operator(). Node 0 contains nothing.
+                const auto& left_value = left_values[k];
+                const auto& right_value = keys[k];
+                return k != 0 && (
+                    (left_value < x && x < right_value) ||
+                    (x == left_value && (brackets[k] & left_closed_flag)) ||
+                    (x == right_value && (brackets[k] & right_closed_flag))
+                );
+            }
+
+            template<class X>
+            bool contains(const X& x) const { return contains_at(lower_bound(x), x); }
+
+            std::size_t size(void) const { return n; }
+
+        private:
+            static constexpr std::size_t line_keys = sizeof(Boundary) < 64 ? 64 / sizeof(Boundary) : 1;
+            static constexpr unsigned char left_closed_flag = 1;
+            static constexpr unsigned char right_closed_flag = 2;
+
+            std::size_t n;
+            std::vector<Boundary> storage;
+            Boundary* keys;
+            std::vector<Boundary> left_values;
+            std::vector<unsigned char> brackets;
+
+            void build(const IntervalArrays<Boundary>& a, std::size_t& i, std::size_t k) {
+                // In-order traversal of the implicit tree, which visits nodes in sorted order.
+                if (k <= n) {
+                    build(a, i, 2*k);
+                    keys[k] = a.right_values[i];
+                    left_values[k] = a.left_values[i];
+                    brackets[k] = (a.left_closed_at(i) ? left_closed_flag : 0) | (a.right_closed_at(i) ? right_closed_flag : 0);
+                    ++i;
+                    build(a, i, 2*k + 1);
+                }
+            }
+
+            void prefetch(std::size_t k) const {
+                // The descendants line_keys positions below k share a cache line.
+                #if defined(__GNUC__)
+                    __builtin_prefetch(reinterpret_cast<const char*>(keys) + k * line_keys * sizeof(Boundary));
+                #endif
+            }
+    };
+
+    template<class Boundary>
+    class SearchIndexCache {
+        // Owns the lazily built EytzingerIndex of an IntervalUnion. Building is a const operation
+        // so that lookups on a const union can publish the index; concurrent builders race with a
+        // compare-exchange and the loser discards its copy. Copies start without an index, moves take
+        // it along with the intervals, and reset() drops it when the intervals change. No index is
+        // built during constant evaluation, where the atomic is never touched.
+
+        public:
+            constexpr SearchIndexCache() = default;
+            constexpr SearchIndexCache(const SearchIndexCache&) { }
+
+            constexpr SearchIndexCache(SearchIndexCache&& rhs) noexcept {
+                if (!std::is_constant_evaluated()) { index.store(rhs.index.exchange(nullptr), std::memory_order_relaxed); }
+            }
+
+            constexpr SearchIndexCache& operator=(const SearchIndexCache&) { reset(); return *this; }
+
+            constexpr SearchIndexCache& operator=(SearchIndexCache&& rhs) noexcept {
+                if (this != &rhs && !std::is_constant_evaluated()) { delete index.exchange(rhs.index.exchange(nullptr)); }
+                return *this;
+            }
+
+            constexpr ~SearchIndexCache() {
+                if (!std::is_constant_evaluated()) { delete index.load(std::memory_order_relaxed); }
+            }
+
+            constexpr const EytzingerIndex<Boundary>* get(void) const {
+                if (std::is_constant_evaluated()) { return nullptr; }
+                return index.load(std::memory_order_acquire);
+            }
+
+            const EytzingerIndex<Boundary>& build(const IntervalArrays<Boundary>& a) const {
+                if (auto existing = get()) { return *existing; }
+                auto built = new EytzingerIndex<Boundary>(a);
+                const EytzingerIndex<Boundary>* expected = nullptr;
+                if (!index.compare_exchange_strong(expected, built, std::memory_order_acq_rel)) {
+                    delete built;
+                    return *expected;
+                }
+                return *built;
+            }
+
+            constexpr void reset(void) {
+                if (!std::is_constant_evaluated()) { delete index.exchange(nullptr); }
+            }
+
+            constexpr void swap(SearchIndexCache& rhs) noexcept {
+                if (std::is_constant_evaluated()) { return; }
+                rhs.index.store(index.exchange(rhs.index.load(std::memory_order_acquire), std::memory_order_acq_rel), std::memory_order_release);
+            }
+
+        private:
+            mutable std::atomic<const EytzingerIndex<Boundary>*> index = nullptr;
+    };
+
+    template<class Boundary, class X>
+    std::uint64_t contains_word_indexed(const EytzingerIndex<Boundary>& index, const X* xs, std::size_t count) {
+        // As contains_word, with the interval for each point found through the index.
+        std::size_t nodes[64];
+        index.lower_bound(xs, count, nodes);
+        std::uint64_t word = 0;
+        for (std::size_t k = 0; k != count; ++k) {
+            word |= std::uint64_t(index.contains_at(nodes[k], xs[k])) << k;
+        }
+        return word;
+    }
+
+    template<class Boundary, class X, class Out>
+    void contains_indexed(const EytzingerIndex<Boundary>& index, const X* xs, std::size_t count, Out* out) {
+        write_contains_words(count, out, [&](std::size_t k, std::size_t chunk) {
+            return contains_word_indexed(index, xs + k, chunk);
+        });
+    }
+
+}}
+
+#endif
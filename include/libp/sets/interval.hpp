@@ -2,6 +2,7 @@
 #define LIBP_SETS_INTERVAL_HPP_GUARD
 
 #include <algorithm>
+#include <array>
 #include <cctype>
 #include <cmath>
 #include <concepts>
@@ -9,40 +10,83 @@
 #include <ostream>
 #include <iterator>
 #include <limits>
+#include <memory>
+#include <memory_resource>
+#include <optional>
 #include <ostream>
+#include <ranges>
+#include <span>
 #include <sstream>
 #include <string>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
+#include <libp/sets/boundary_traits.hpp>
+#include <libp/sets/detail/interval_contains.hpp>
+#include <libp/sets/detail/interval_merge.hpp>
+#include <libp/sets/detail/interval_sweep.hpp>
+#include <libp/sets/detail/search_index.hpp>
+
 namespace libp {
 
     template<class Boundary>
     concept BoundaryConcept = requires(Boundary x, Boundary y) {
         requires std::default_initializable<Boundary>;
         requires std::totally_ordered<Boundary>;
-        std::numeric_limits<Boundary>::infinity();
-        std::numeric_limits<Boundary>::quiet_NaN();
+        { boundary_traits<Boundary>::infinity() } -> std::convertible_to<Boundary>;
+        { boundary_traits<Boundary>::negative_infinity() } -> std::convertible_to<Boundary>;
+        { boundary_traits<Boundary>::nan() } -> std::convertible_to<Boundary>;
+        { boundary_traits<Boundary>::isnan(x) } -> std::convertible_to<bool>;
         std::min(x,y);
         std::max(x,y);
     };
 
-    template<BoundaryConcept Boundary>
+    template<BoundaryConcept Boundary, std::size_t InlineCapacity, class Allocator>
+    class IntervalVector;
+
+    // Unions store up to InlineCapacity intervals without allocating, and take any larger storage from
+    // Allocator.
+    template<BoundaryConcept Boundary, std::size_t InlineCapacity = 2, class Allocator = std::allocator<Boundary>>
     class IntervalUnion;
 
+    namespace detail {
+        struct IntervalUnionAccess;
+
+        template<class Union, class RhsBoundary>
+        struct common_interval_union;
+
+        template<BoundaryConcept Boundary, std::size_t InlineCapacity, class Allocator, class RhsBoundary>
+        struct common_interval_union<IntervalUnion<Boundary, InlineCapacity, Allocator>, RhsBoundary> {
+            // The result of a binary set operation: the common boundary type, with the inline capacity
+            // and allocator of the left operand.
+            using boundary_type = common_boundary_t<Boundary, RhsBoundary>;
+            using type = IntervalUnion<
+                boundary_type,
+                InlineCapacity,
+                typename std::allocator_traits<Allocator>::template rebind_alloc<boundary_type>
+            >;
+        };
+
+        template<class Union, class RhsBoundary>
+        using common_interval_union_t = typename common_interval_union<Union, RhsBoundary>::type;
+    }
+
     template<BoundaryConcept Boundary>
     class Interval {
         template<BoundaryConcept B>
         friend class Interval;
 
-        template<BoundaryConcept B>
+        template<BoundaryConcept B, std::size_t N, class A>
+        friend class IntervalVector;
+
+        template<BoundaryConcept B, std::size_t N, class A>
         friend class IntervalUnion;
 
         public:
             using boundary_type = Boundary;
 
-            Interval(): 
+            constexpr Interval(): 
                 left_value_m(0),
                 right_value_m(0),
                 left_bracket_m('('),
@@ -50,7 +94,7 @@ namespace libp {
             { }
 
             template<BoundaryConcept S, BoundaryConcept T>
-            Interval(char left_bracket_in, S left_value_in, T right_value_in, char right_bracket_in):
+            constexpr Interval(char left_bracket_in, S left_value_in, T right_value_in, char right_bracket_in):
                 left_value_m(std::move(left_value_in)),
                 right_value_m(std::move(right_value_in)),
                 left_bracket_m(left_bracket_in),
@@ -59,52 +103,65 @@ namespace libp {
                 if (
                     (left_bracket_m != '(' && left_bracket_m != '[') ||
                     (right_bracket_m != ')' && right_bracket_m != ']') ||
-                    std::isnan(left_value_m) || std::isnan(right_value_m)
+                    boundary_traits<Boundary>::isnan(left_value_m) || boundary_traits<Boundary>::isnan(right_value_m)
                 ) {
                     set_to_nan();
-                } else if (isempty()) {
-                    set_to_empty();
+                    return;
+                }
+                if constexpr (boundary_traits<Boundary>::discrete) {
+                    if (left_bracket_m == '(' && detail::isfinite_boundary(left_value_m)) {
+                        ++left_value_m;
+                        left_bracket_m = '[';
+                    }
+                    if (right_bracket_m == ']' && detail::isfinite_boundary(right_value_m)) {
+                        ++right_value_m;
+                        right_bracket_m = ')';
+                    }
                 }
+                if (isempty()) { set_to_empty(); }
             }
 
             template<BoundaryConcept RhsBoundary>
-            Interval(const Interval<RhsBoundary>& rhs):
-                left_value_m(rhs.left_value_m),
-                right_value_m(rhs.right_value_m),
-                left_bracket_m(rhs.left_bracket_m),
-                right_bracket_m(rhs.right_bracket_m)
+            constexpr Interval(const Interval<RhsBoundary>& rhs):
+                // Through the constructor above, which makes the brackets half-open for a discrete type.
+                Interval(
+                    rhs.left_bracket_m,
+                    detail::convert_boundary<Boundary>(rhs.left_value_m),
+                    detail::convert_boundary<Boundary>(rhs.right_value_m),
+                    rhs.right_bracket_m
+                )
             { }
 
-            auto left_value(void) const { return left_value_m; }
-            auto left_bracket(void) const { return left_bracket_m; }
+            constexpr auto left_value(void) const { return left_value_m; }
+            constexpr auto left_bracket(void) const { return left_bracket_m; }
 
-            auto right_value(void) const { return right_value_m; }
-            auto right_bracket(void) const { return right_bracket_m; }
+            constexpr auto right_value(void) const { return right_value_m; }
+            constexpr auto right_bracket(void) const { return right_bracket_m; }
 
-            auto open(void) const { return left_bracket() == '(' && right_bracket() == ')'; }
-            auto closed(void) const { return left_bracket() == '[' && right_bracket() == ']'; }
+            constexpr auto open(void) const { return left_bracket() == '(' && right_bracket() == ')'; }
+            constexpr auto closed(void) const { return left_bracket() == '[' && right_bracket() == ']'; }
 
-            auto isempty(void) const {
+            constexpr auto isempty(void) const {
                 // Does not assume that we're in a canonical representation, but does assume that the
                 // left bracket is '(' or '[', likewise for the right bracket. Returns false if NaN.
-                return ((left_value_m == right_value_m && !closed()) || left_value_m > right_value_m);
+                return !isnan() && ((left_value_m == right_value_m && !closed()) || left_value_m > right_value_m);
             }
 
-            auto issingleton(void) const {
+            constexpr auto issingleton(void) const {
                 return left_value_m == right_value_m && closed();
             }
 
-            auto isnan(void) const { return std::isnan(left_value_m); }
+            constexpr auto isnan(void) const { return boundary_traits<Boundary>::isnan(left_value_m); }
 
             template<BoundaryConcept BoundaryX>
-            auto operator()(const BoundaryX& x) const {
+            constexpr auto operator()(const BoundaryX& x) const {
                 return (left_value() < x && x < right_value()) ||
                     (x == left_value() && left_bracket() == '[') ||
                     (x == right_value() && right_bracket() == ']');
             }
 
             template<BoundaryConcept B>
-            bool operator==(const Interval<B>& rhs) const {
+            constexpr bool operator==(const Interval<B>& rhs) const {
                 return left_bracket_m == rhs.left_bracket_m &&
                     left_value_m == rhs.left_value_m &&
                     right_value_m == rhs.right_value_m &&
@@ -112,7 +169,7 @@ namespace libp {
             }
 
             template<BoundaryConcept B>
-            bool operator!=(const Interval<B>& rhs) const {
+            constexpr bool operator!=(const Interval<B>& rhs) const {
                 if (isnan() || rhs.isnan()) {
                     return false;
                 } else {
@@ -120,15 +177,15 @@ namespace libp {
                 }
             }
 
-            static Interval<Boundary> empty(void) {
+            static constexpr Interval<Boundary> empty(void) {
                 return {};
             }
 
-            static Interval<Boundary> universal(bool extended_real_line = false) {
+            static constexpr Interval<Boundary> universal(bool extended_real_line = false) {
                 return Interval<Boundary>().inv(extended_real_line);
             }
 
-            static Interval<Boundary> nan(void) {
+            static constexpr Interval<Boundary> nan(void) {
                 Interval<Boundary> ret;
                 ret.set_to_nan();
                 return ret;
@@ -140,17 +197,17 @@ namespace libp {
             char left_bracket_m;
             char right_bracket_m;
 
-            void set_to_empty(void) {
+            constexpr void set_to_empty(void) {
                 left_bracket_m = '(';
                 left_value_m = 0;
                 right_value_m = 0;
                 right_bracket_m = ')';
             }
 
-            void set_to_nan(void) {
+            constexpr void set_to_nan(void) {
                 left_bracket_m = '(';
-                left_value_m = std::numeric_limits<Boundary>::quiet_NaN();
-                right_value_m = std::numeric_limits<Boundary>::quiet_NaN();
+                left_value_m = boundary_traits<Boundary>::nan();
+                right_value_m = boundary_traits<Boundary>::nan();
                 right_bracket_m = ']';
             };
     };
@@ -219,9 +276,9 @@ namespace libp {
             // Try negatively infinite boundary.
             isn.clear();
             if (maybe_minus == '-') { isn.putback('-'); }
-            auto inf = std::numeric_limits<Boundary>::infinity();
-            if (std::ostringstream ss; (ss << -inf) && match(isn, ss.str())) {
-                b = -inf;
+            auto inf = boundary_traits<Boundary>::infinity();
+            if (std::ostringstream ss; (ss << boundary_traits<Boundary>::negative_infinity()) && match(isn, ss.str())) {
+                b = boundary_traits<Boundary>::negative_infinity();
                 return isn;
             }
 
@@ -234,7 +291,7 @@ namespace libp {
 
             // Try nan boundary.
             isn.clear();
-            auto nan = std::numeric_limits<Boundary>::quiet_NaN();
+            auto nan = boundary_traits<Boundary>::nan();
             if (std::ostringstream ss; (ss << nan) && match(isn, ss.str())) {
                 b = nan;
                 return isn;
@@ -303,203 +360,647 @@ namespace libp {
         return is;
     }
 
-    template<BoundaryConcept Boundary>
+    namespace detail {
+
+        template<class Intervals>
+        class IntervalIterator {
+            // A random access iterator over a sequence of intervals whose reference type is an
+            // Interval prvalue assembled on dereference by intervals[i].
+
+            public:
+                using value_type = typename Intervals::value_type;
+                using reference = value_type;
+                using difference_type = std::ptrdiff_t;
+                using iterator_category = std::input_iterator_tag;
+                using iterator_concept = std::random_access_iterator_tag;
+
+                struct pointer {
+                    value_type interval;
+                    const value_type* operator->(void) const { return &interval; }
+                };
+
+                constexpr IntervalIterator() = default;
+
+                constexpr IntervalIterator(const Intervals* intervals_in, std::size_t i_in):
+                    intervals(intervals_in),
+                    i(i_in)
+                { }
+
+                constexpr reference operator*(void) const { return (*intervals)[i]; }
+                constexpr pointer operator->(void) const { return {**this}; }
+                constexpr reference operator[](difference_type n) const { return (*intervals)[i + n]; }
+
+                constexpr IntervalIterator& operator++(void) { ++i; return *this; }
+                constexpr IntervalIterator operator++(int) { auto ret = *this; ++i; return ret; }
+                constexpr IntervalIterator& operator--(void) { --i; return *this; }
+                constexpr IntervalIterator operator--(int) { auto ret = *this; --i; return ret; }
+                constexpr IntervalIterator& operator+=(difference_type n) { i += n; return *this; }
+                constexpr IntervalIterator& operator-=(difference_type n) { i -= n; return *this; }
+
+                friend constexpr IntervalIterator operator+(IntervalIterator iter, difference_type n) { return iter += n; }
+                friend constexpr IntervalIterator operator+(difference_type n, IntervalIterator iter) { return iter += n; }
+                friend constexpr IntervalIterator operator-(IntervalIterator iter, difference_type n) { return iter -= n; }
+                friend constexpr difference_type operator-(const IntervalIterator& lhs, const IntervalIterator& rhs) {
+                    return static_cast<difference_type>(lhs.i) - static_cast<difference_type>(rhs.i);
+                }
+
+                constexpr bool operator==(const IntervalIterator& rhs) const { return i == rhs.i; }
+                constexpr auto operator<=>(const IntervalIterator& rhs) const { return i <=> rhs.i; }
+
+            private:
+                const Intervals* intervals = nullptr;
+                std::size_t i = 0;
+        };
+
+    }
+
+    template<BoundaryConcept Boundary, std::size_t InlineCapacity, class Allocator>
+    class IntervalVector {
+        // A sequence of intervals stored as a structure of arrays: the left and right values live in
+        // two contiguous arrays and the brackets are packed into two bitsets, with a set bit marking a
+        // closed bracket. For double boundaries this costs 16.25 bytes per interval rather than the 24
+        // bytes of a padded Interval<double>, and merge loops that only compare values never touch the
+        // brackets. Bits at positions at or beyond size() are kept clear.
+        //
+        // The first InlineCapacity intervals are stored inside the object, and the arrays only move to
+        // storage from the allocator when a sequence outgrows them. The array pointers always point at
+        // whichever storage is in use, so element access does not branch on where the intervals live.
+        // The allocator is propagated on copy, move and swap as its allocator_traits direct.
+
+        template<BoundaryConcept B, std::size_t N, class A>
+        friend class IntervalVector;
+
+        static_assert(std::is_same_v<typename Allocator::value_type, Boundary>);
+
+        using allocator_traits = std::allocator_traits<Allocator>;
+        using word_allocator = typename allocator_traits::template rebind_alloc<std::uint64_t>;
+        using word_allocator_traits = std::allocator_traits<word_allocator>;
+
+        public:
+            using value_type = Interval<Boundary>;
+            using size_type = std::size_t;
+            using difference_type = std::ptrdiff_t;
+            using allocator_type = Allocator;
+
+            using const_iterator = detail::IntervalIterator<IntervalVector>;
+
+            constexpr IntervalVector(): IntervalVector(Allocator()) { }
+
+            explicit constexpr IntervalVector(const Allocator& allocator_in): allocator_m(allocator_in) { point_at_inline_storage(); }
+
+            constexpr IntervalVector(const IntervalVector& rhs):
+                IntervalVector(allocator_traits::select_on_container_copy_construction(rhs.allocator_m))
+            {
+                copy_from(rhs);
+            }
+
+            constexpr IntervalVector(IntervalVector&& rhs) noexcept(std::is_nothrow_move_assignable_v<Boundary>):
+                IntervalVector(rhs.allocator_m)
+            {
+                move_from(rhs);
+            }
+
+            constexpr ~IntervalVector() { release(); }
+
+            constexpr IntervalVector& operator=(const IntervalVector& rhs) {
+                if (this != &rhs) {
+                    if constexpr (allocator_traits::propagate_on_container_copy_assignment::value) {
+                        if (allocator_m != rhs.allocator_m) { release(); }
+                        allocator_m = rhs.allocator_m;
+                    }
+                    copy_from(rhs);
+                }
+                return *this;
+            }
+
+            // Moving between allocators that compare unequal and do not propagate allocates, so may throw.
+            constexpr IntervalVector& operator=(IntervalVector&& rhs) noexcept(
+                (allocator_traits::propagate_on_container_move_assignment::value ||
+                    allocator_traits::is_always_equal::value) &&
+                std::is_nothrow_move_assignable_v<Boundary>
+            ) {
+                if (this != &rhs) {
+                    if constexpr (allocator_traits::propagate_on_container_move_assignment::value) {
+                        release();
+                        allocator_m = rhs.allocator_m;
+                    }
+                    move_from(rhs);
+                }
+                return *this;
+            }
+
+            constexpr allocator_type get_allocator(void) const { return allocator_m; }
+
+            constexpr size_type size(void) const { return size_m; }
+            constexpr bool empty(void) const { return size_m == 0; }
+            constexpr size_type capacity(void) const { return capacity_m; }
+            constexpr bool is_inline(void) const { return heap_values == nullptr; }
+
+            constexpr void reserve(size_type n) {
+                if (n > capacity_m) { reallocate(n); }
+            }
+
+            constexpr void clear(void) { truncate(0); }
+
+            constexpr void truncate(size_type n) {
+                // Erases every interval from position n onwards.
+                if (n >= size_m) { return; }
+                std::fill(left_closed_m + words_for(n), left_closed_m + words_for(size_m), std::uint64_t(0));
+                std::fill(right_closed_m + words_for(n), right_closed_m + words_for(size_m), std::uint64_t(0));
+                if (auto tail = n % word_bits; tail != 0) {
+                    left_closed_m[n / word_bits] &= (std::uint64_t(1) << tail) - 1;
+                    right_closed_m[n / word_bits] &= (std::uint64_t(1) << tail) - 1;
+                }
+                size_m = n;
+            }
+
+            constexpr void grow_front(size_type k) {
+                // Moves every interval k positions towards the back, leaving k intervals with unspecified
+                // contents at the front.
+                auto n = size_m;
+                reserve(n + k);
+                std::move_backward(left_values_m, left_values_m + n, left_values_m + n + k);
+                std::move_backward(right_values_m, right_values_m + n, right_values_m + n + k);
+                for (auto i = n; i-- != 0; ) {
+                    set_bit(left_closed_m, i + k, test_bit(left_closed_m, i));
+                    set_bit(right_closed_m, i + k, test_bit(right_closed_m, i));
+                }
+                size_m = n + k;
+            }
+
+            constexpr void resize_for_overwrite(size_type n) {
+                // Resizes to n intervals, leaving any new intervals with unspecified values and open
+                // brackets for the caller to set.
+                if (n < size_m) { truncate(n); return; }
+                reserve(n);
+                size_m = n;
+            }
+
+            constexpr void swap(IntervalVector& rhs) {
+                // As for the standard containers, the allocators must compare equal unless they
+                // propagate on swap.
+                if (!is_inline() && !rhs.is_inline()) {
+                    if constexpr (allocator_traits::propagate_on_container_swap::value) {
+                        std::swap(allocator_m, rhs.allocator_m);
+                    }
+                    std::swap(left_values_m, rhs.left_values_m);
+                    std::swap(right_values_m, rhs.right_values_m);
+                    std::swap(left_closed_m, rhs.left_closed_m);
+                    std::swap(right_closed_m, rhs.right_closed_m);
+                    std::swap(size_m, rhs.size_m);
+                    std::swap(capacity_m, rhs.capacity_m);
+                    std::swap(heap_values, rhs.heap_values);
+                    std::swap(heap_closed, rhs.heap_closed);
+                } else {
+                    IntervalVector tmp(std::move(rhs));
+                    rhs = std::move(*this);
+                    *this = std::move(tmp);
+                }
+            }
+
+            constexpr const Boundary* left_values(void) const { return left_values_m; }
+            constexpr const Boundary* right_values(void) const { return right_values_m; }
+
+            constexpr const Boundary& left_value(size_type i) const { return left_values_m[i]; }
+            constexpr const Boundary& right_value(size_type i) const { return right_values_m[i]; }
+
+            constexpr bool left_closed(size_type i) const { return test_bit(left_closed_m, i); }
+            constexpr bool right_closed(size_type i) const { return test_bit(right_closed_m, i); }
+
+            constexpr detail::IntervalArrays<Boundary> arrays(void) const {
+                return {left_values_m, right_values_m, left_closed_m, right_closed_m, size_m};
+            }
+
+            // The arrays behind arrays(), for bulk writes after resize_for_overwrite. Bits at or past
+            // size() must be left clear.
+            constexpr Boundary* left_values_data(void) { return left_values_m; }
+            constexpr Boundary* right_values_data(void) { return right_values_m; }
+            constexpr std::uint64_t* left_closed_words(void) { return left_closed_m; }
+            constexpr std::uint64_t* right_closed_words(void) { return right_closed_m; }
+
+            constexpr char left_bracket(size_type i) const { return left_closed(i) ? '[' : '('; }
+            constexpr char right_bracket(size_type i) const { return right_closed(i) ? ']' : ')'; }
+
+            constexpr Interval<Boundary> operator[](size_type i) const {
+                Interval<Boundary> I;
+                I.left_value_m = left_values_m[i];
+                I.right_value_m = right_values_m[i];
+                I.left_bracket_m = left_bracket(i);
+                I.right_bracket_m = right_bracket(i);
+                return I;
+            }
+
+            constexpr Interval<Boundary> front(void) const { return (*this)[0]; }
+            constexpr Interval<Boundary> back(void) const { return (*this)[size() - 1]; }
+
+            constexpr const_iterator cbegin(void) const { return const_iterator(this, 0); }
+            constexpr const_iterator cend(void) const { return const_iterator(this, size()); }
+
+            constexpr void push_back(Boundary left_value_in, bool left_closed_in, Boundary right_value_in, bool right_closed_in) {
+                if (size_m == capacity_m) { reallocate(std::max<size_type>(2*capacity_m, 4)); }
+                auto i = size_m++;
+                left_values_m[i] = std::move(left_value_in);
+                right_values_m[i] = std::move(right_value_in);
+                set_bit(left_closed_m, i, left_closed_in);
+                set_bit(right_closed_m, i, right_closed_in);
+            }
+
+            template<BoundaryConcept B>
+            constexpr void push_back(const Interval<B>& I) {
+                const Interval<Boundary>& J = I;
+                push_back(J.left_value_m, J.left_bracket_m == '[', J.right_value_m, J.right_bracket_m == ']');
+            }
+
+            template<BoundaryConcept B>
+            constexpr void emplace_back(const Interval<B>& I) { push_back(I); }
+
+            template<BoundaryConcept S, BoundaryConcept T>
+            constexpr void emplace_back(char left_bracket_in, S left_value_in, T right_value_in, char right_bracket_in) {
+                push_back(Interval<Boundary>(left_bracket_in, std::move(left_value_in), std::move(right_value_in), right_bracket_in));
+            }
+
+            constexpr void set_left(size_type i, Boundary value, bool closed) {
+                left_values_m[i] = std::move(value);
+                set_bit(left_closed_m, i, closed);
+            }
+
+            constexpr void set_right(size_type i, Boundary value, bool closed) {
+                right_values_m[i] = std::move(value);
+                set_bit(right_closed_m, i, closed);
+            }
+
+            constexpr void assign(size_type i, size_type j) {
+                // Copies the interval at position j over the interval at position i.
+                set_left(i, left_values_m[j], left_closed(j));
+                set_right(i, right_values_m[j], right_closed(j));
+            }
+
+        private:
+            static constexpr size_type word_bits = 64;
+
+            static constexpr size_type words_for(size_type n) { return (n + word_bits - 1) / word_bits; }
+
+            Boundary* left_values_m;
+            Boundary* right_values_m;
+            std::uint64_t* left_closed_m;
+            std::uint64_t* right_closed_m;
+            size_type size_m = 0;
+            size_type capacity_m = InlineCapacity;
+
+            std::array<Boundary, InlineCapacity> inline_left_values;
+            std::array<Boundary, InlineCapacity> inline_right_values;
+            std::array<std::uint64_t, words_for(InlineCapacity)> inline_left_closed = {};
+            std::array<std::uint64_t, words_for(InlineCapacity)> inline_right_closed = {};
+
+            // The allocated storage, holding capacity() left values followed by as many right values,
+            // and the left bracket words followed by the right bracket words. Both are null while the
+            // intervals are stored inline.
+            Boundary* heap_values = nullptr;
+            std::uint64_t* heap_closed = nullptr;
+
+            [[no_unique_address]] Allocator allocator_m;
+
+            // Boundaries that need no construction or destruction are left uninitialised until written,
+            // except during constant evaluation, where allocated storage holds no objects until they are
+            // constructed.
+            static constexpr bool construct_values = !std::is_trivially_default_constructible_v<Boundary> ||
+                !std::is_trivially_destructible_v<Boundary>;
+
+            static constexpr bool constructs_values(void) { return construct_values || std::is_constant_evaluated(); }
+
+            constexpr void point_at_inline_storage(void) {
+                left_values_m = inline_left_values.data();
+                right_values_m = inline_right_values.data();
+                left_closed_m = inline_left_closed.data();
+                right_closed_m = inline_right_closed.data();
+                capacity_m = InlineCapacity;
+            }
+
+            constexpr void release(void) {
+                // Returns any allocated storage, leaving the intervals stored inline and empty.
+                if (is_inline()) { return; }
+                if (constructs_values()) {
+                    for (size_type i = 0; i != 2*capacity_m; ++i) { allocator_traits::destroy(allocator_m, heap_values + i); }
+                }
+                allocator_traits::deallocate(allocator_m, heap_values, 2*capacity_m);
+                word_allocator words(allocator_m);
+                word_allocator_traits::deallocate(words, heap_closed, 2*words_for(capacity_m));
+                heap_values = nullptr;
+                heap_closed = nullptr;
+                size_m = 0;
+                point_at_inline_storage();
+            }
+
+            constexpr void reallocate(size_type n) {
+                // Moves the intervals into allocated storage for n >= size() intervals.
+                Boundary* values = allocator_traits::allocate(allocator_m, 2*n);
+                if (constructs_values()) {
+                    for (size_type i = 0; i != 2*n; ++i) { allocator_traits::construct(allocator_m, values + i); }
+                }
+                word_allocator words(allocator_m);
+                std::uint64_t* closed = word_allocator_traits::allocate(words, 2*words_for(n));
+                if (std::is_constant_evaluated()) {
+                    for (size_type k = 0; k != 2*words_for(n); ++k) { std::construct_at(closed + k, std::uint64_t(0)); }
+                } else {
+                    std::fill(closed, closed + 2*words_for(n), std::uint64_t(0));
+                }
+                std::move(left_values_m, left_values_m + size_m, values);
+                std::move(right_values_m, right_values_m + size_m, values + n);
+                std::copy(left_closed_m, left_closed_m + words_for(size_m), closed);
+                std::copy(right_closed_m, right_closed_m + words_for(size_m), closed + words_for(n));
+                auto size = size_m;
+                release();
+                heap_values = values;
+                heap_closed = closed;
+                left_values_m = values;
+                right_values_m = values + n;
+                left_closed_m = closed;
+                right_closed_m = closed + words_for(n);
+                size_m = size;
+                capacity_m = n;
+            }
+
+            constexpr void copy_from(const IntervalVector& rhs) {
+                clear();
+                reserve(rhs.size_m);
+                std::copy(rhs.left_values_m, rhs.left_values_m + rhs.size_m, left_values_m);
+                std::copy(rhs.right_values_m, rhs.right_values_m + rhs.size_m, right_values_m);
+                std::copy(rhs.left_closed_m, rhs.left_closed_m + words_for(rhs.size_m), left_closed_m);
+                std::copy(rhs.right_closed_m, rhs.right_closed_m + words_for(rhs.size_m), right_closed_m);
+                size_m = rhs.size_m;
+            }
+
+            constexpr void move_from(IntervalVector& rhs) {
+                // Takes over the allocated storage of rhs when this vector's allocator can free it, and
+                // otherwise moves the intervals one by one. Leaves rhs empty.
+                if (rhs.is_inline() || allocator_m != rhs.allocator_m) {
+                    clear();
+                    reserve(rhs.size_m);
+                    std::move(rhs.left_values_m, rhs.left_values_m + rhs.size_m, left_values_m);
+                    std::move(rhs.right_values_m, rhs.right_values_m + rhs.size_m, right_values_m);
+                    std::copy(rhs.left_closed_m, rhs.left_closed_m + words_for(rhs.size_m), left_closed_m);
+                    std::copy(rhs.right_closed_m, rhs.right_closed_m + words_for(rhs.size_m), right_closed_m);
+                    size_m = rhs.size_m;
+                    rhs.clear();
+                } else {
+                    release();
+                    heap_values = std::exchange(rhs.heap_values, nullptr);
+                    heap_closed = std::exchange(rhs.heap_closed, nullptr);
+                    left_values_m = rhs.left_values_m;
+                    right_values_m = rhs.right_values_m;
+                    left_closed_m = rhs.left_closed_m;
+                    right_closed_m = rhs.right_closed_m;
+                    size_m = rhs.size_m;
+                    capacity_m = rhs.capacity_m;
+                    rhs.size_m = 0;
+                    rhs.point_at_inline_storage();
+                }
+            }
+
+            static constexpr bool test_bit(const std::uint64_t* words, size_type i) {
+                return (words[i / word_bits] >> (i % word_bits)) & 1;
+            }
+
+            static constexpr void set_bit(std::uint64_t* words, size_type i, bool value) {
+                auto mask = std::uint64_t(1) << (i % word_bits);
+                auto& word = words[i / word_bits];
+                word = (word & ~mask) | (-std::uint64_t(value) & mask);
+            }
+    };
+
+    template<BoundaryConcept Boundary, std::size_t InlineCapacity, class Allocator>
     class IntervalUnion {
-        template<BoundaryConcept B>
+        template<BoundaryConcept B, std::size_t N, class A>
         friend class IntervalUnion;
 
+        friend struct detail::IntervalUnionAccess;
+
         public:
             using boundary_type = Boundary;
+            using allocator_type = Allocator;
+            using vector_type = IntervalVector<Boundary, InlineCapacity, Allocator>;
+            using const_iterator = typename vector_type::const_iterator;
+
+            constexpr IntervalUnion() = default;
 
-            IntervalUnion() = default;
+            explicit constexpr IntervalUnion(const Allocator& allocator):
+                intervals(allocator)
+            { }
 
             template<BoundaryConcept IntBoundary>
-            IntervalUnion(Interval<IntBoundary> interval) {
-                if (!interval.isempty()) { intervals.emplace_back(std::move(interval)); }
+            constexpr IntervalUnion(Interval<IntBoundary> interval, const Allocator& allocator = Allocator()):
+                intervals(allocator)
+            {
+                const Interval<Boundary>& I = interval;
+                if (!I.isempty()) { intervals.push_back(I); }
             }
 
             template<BoundaryConcept S, BoundaryConcept T>
-            IntervalUnion(char left_bracket_in, S left_value_in, T right_value_in, char right_bracket_in):
-                IntervalUnion(Interval<Boundary>(left_bracket_in, std::move(left_value_in), std::move(right_value_in), right_bracket_in))
+            constexpr IntervalUnion(char left_bracket_in, S left_value_in, T right_value_in, char right_bracket_in, const Allocator& allocator = Allocator()):
+                IntervalUnion(Interval<Boundary>(left_bracket_in, std::move(left_value_in), std::move(right_value_in), right_bracket_in), allocator)
             { }
 
             template<std::forward_iterator Iter>
-            IntervalUnion(Iter first, Iter last) {
+            constexpr IntervalUnion(Iter first, Iter last, const Allocator& allocator = Allocator()):
+                intervals(allocator)
+            {
                 intervals.reserve(std::distance(first, last));
                 for (auto iter = first; iter != last; ++iter) {
                     const Interval<Boundary>& I = *iter;
                     if (I.isnan()) {
                         intervals.clear();
-                        intervals.emplace_back(I);
+                        intervals.push_back(I);
                         return;
                     } else if (!I.isempty()) {
-                        intervals.emplace_back(I);
+                        intervals.push_back(I);
                     }
                 }
                 canonicalise_unempty_intervals();
             }
 
-            IntervalUnion(std::initializer_list<Interval<Boundary>> l):
-                IntervalUnion(l.begin(), l.end())
+            constexpr IntervalUnion(std::initializer_list<Interval<Boundary>> l, const Allocator& allocator = Allocator()):
+                IntervalUnion(l.begin(), l.end(), allocator)
             { }
 
-            template<BoundaryConcept RhsBoundary>
-            IntervalUnion(const IntervalUnion<RhsBoundary>& rhs):
-                IntervalUnion(rhs.cbegin(), rhs.cend())
+            template<BoundaryConcept RhsBoundary, std::size_t RhsCapacity, class RhsAllocator>
+            constexpr IntervalUnion(const IntervalUnion<RhsBoundary, RhsCapacity, RhsAllocator>& rhs, const Allocator& allocator = Allocator()):
+                IntervalUnion(rhs.cbegin(), rhs.cend(), allocator)
             { }
 
-            auto cbegin(void) const { return intervals.cbegin(); }
-            auto cend(void) const { return intervals.cend(); }
+            constexpr allocator_type get_allocator(void) const { return intervals.get_allocator(); }
 
-            bool isempty(void) const { return intervals.empty(); }
+            constexpr const_iterator cbegin(void) const { return intervals.cbegin(); }
+            constexpr const_iterator cend(void) const { return intervals.cend(); }
 
-            bool issingleton(void) const { return intervals.size() == 1 && intervals[1].issingleton(); }
+            constexpr void swap(IntervalUnion& rhs) {
+                // Exchanges heap storage by pointer, and only moves intervals stored inline.
+                intervals.swap(rhs.intervals);
+                search_index.swap(rhs.search_index);
+            }
 
-            bool isnan(void) const { return !isempty() && intervals.front().isnan(); }
+            friend constexpr void swap(IntervalUnion& lhs, IntervalUnion& rhs) { lhs.swap(rhs); }
 
-            static IntervalUnion<Boundary> empty(void) { return {}; }
+            constexpr bool isempty(void) const { return intervals.empty(); }
 
-            static IntervalUnion<Boundary> universal(bool extended_real_line = false) {
-                return IntervalUnion<Boundary>().inv(extended_real_line);
-            }
+            constexpr bool issingleton(void) const { return intervals.size() == 1 && intervals.front().issingleton(); }
 
-            static IntervalUnion<Boundary> nan(void) { return Interval<Boundary>::nan(); }
+            constexpr bool isnan(void) const { return !isempty() && boundary_traits<Boundary>::isnan(intervals.left_value(0)); }
 
-            IntervalUnion<Boundary> inv(bool extended_real_line = false) const {
-                if (intervals.size() == 0) {
-                    return Interval<Boundary>(
-                        extended_real_line ? '[' : '(',
-                        -std::numeric_limits<Boundary>::infinity(),
-                        std::numeric_limits<Boundary>::infinity(),
-                        extended_real_line ? ']' : ')'
-                    );
-                } else {
-                    const auto& first_interval = intervals.front();
-                    if (first_interval.isnan()) {
-                        return *this;
-                    } else {
-                        auto intervals_size = intervals.size();
-
-                        IntervalUnion<Boundary> complement; complement.intervals.reserve(intervals_size + 1);
-                        
-                        Interval<Boundary> new_first_interval(
-                            extended_real_line ? '[' : '(',
-                            -std::numeric_limits<Boundary>::infinity(),
-                            first_interval.left_value(),
-                            first_interval.left_bracket() == '[' ? ')' : ']'
-                        );
-                        if (!new_first_interval.isempty()) {
-                            complement.intervals.emplace_back(new_first_interval);
-                        }
-
-                        for (decltype(intervals_size) i = 0; i != intervals_size-1; ++i) {
-                            complement.intervals.emplace_back(
-                                intervals[i].right_bracket() == ']' ? '(' : '[',
-                                intervals[i].right_value(),
-                                intervals[i+1].left_value(),
-                                intervals[i+1].left_bracket() == '[' ? ')' : ']'
-                            );
-                        }
+            static constexpr IntervalUnion empty(const Allocator& allocator = Allocator()) { return IntervalUnion(allocator); }
 
-                        const auto& last_interval = intervals.back();
-                        Interval<Boundary> new_last_interval(
-                            last_interval.right_bracket() == ']' ? '(' : '[',
-                            last_interval.right_value(),
-                            std::numeric_limits<Boundary>::infinity(),
-                            extended_real_line ? ']' : ')'
-                        );
-                        if (!new_last_interval.isempty()) {
-                            complement.intervals.emplace_back(std::move(new_last_interval));
-                        }
+            static constexpr IntervalUnion universal(bool extended_real_line = false, const Allocator& allocator = Allocator()) {
+                return IntervalUnion(allocator).inv(extended_real_line);
+            }
 
-                        return complement;
-                    }
+            static constexpr IntervalUnion nan(const Allocator& allocator = Allocator()) { return IntervalUnion(Interval<Boundary>::nan(), allocator); }
+
+            // The set operations allocate their results from the allocator of their left operand,
+            // rebound to the boundary type of the result.
+
+            constexpr IntervalUnion inv(bool extended_real_line = false) const {
+                if (isnan()) { return *this; }
+                detail::ComplementIntervals<vector_type, Boundary> complement(intervals, extended_real_line);
+                IntervalUnion ret(get_allocator()); ret.intervals.reserve(complement.size());
+                for (std::size_t j = 0; j != complement.size(); ++j) {
+                    ret.intervals.push_back(
+                        complement.left_value(j),
+                        complement.left_closed(j),
+                        complement.right_value(j),
+                        complement.right_closed(j)
+                    );
                 }
+                return ret;
             }
 
-            IntervalUnion<Boundary> operator!() const {
-                const auto& front = intervals.front();
-                const auto& back = intervals.back();
+            constexpr IntervalUnion operator!() const {
+                const auto inf = boundary_traits<Boundary>::infinity();
                 return inv(
-                    !empty() && (
-                        (front.left_value() == -std::numeric_limits<Boundary>::infinity() && front.left_bracket() == '[') ||
-                        (back.right_value() == std::numeric_limits<Boundary>::infinity() && back.right_bracket() == ']')
+                    !isempty() && (
+                        detail::contains_negative_infinity(intervals.left_value(0), intervals.left_closed(0)) ||
+                        (intervals.right_value(intervals.size() - 1) == inf && intervals.right_closed(intervals.size() - 1))
                     )
                 );
             }
 
-            template<BoundaryConcept RhsBoundary>
-            auto operator&&(const IntervalUnion<RhsBoundary>& rhs) const {
-                using CommonBoundary = std::common_type_t<Boundary, RhsBoundary>;
-                using CommonInterval = Interval<CommonBoundary>;
-                using CommonIntervalUnion = IntervalUnion<CommonBoundary>;
-                if (isnan() || rhs.isnan()) { return CommonIntervalUnion::nan(); }
-                CommonIntervalUnion intersection;
-                if (intervals.size() != 0 && rhs.intervals.size() != 0) {
-                    intersection.intervals.reserve(std::max(intervals.size(), rhs.intervals.size()));
-                    auto lhs_iter = intervals.cbegin();
-                    auto lhs_end = intervals.cend();
-                    auto rhs_iter = rhs.intervals.cbegin();
-                    auto rhs_end = rhs.intervals.cend();
-                    CommonInterval I = *lhs_iter;
-                    CommonInterval J = *rhs_iter;
-                    while (true) {
-                        std::tie(I,J) = interval_intersection_right_remainder(I,J);
-                        if (!I.isempty()) { intersection.intervals.emplace_back(std::move(I)); }
-                        if (J.isempty()) {
-                            if (++lhs_iter == lhs_end || ++rhs_iter == rhs_end) { break; }
-                            I = *lhs_iter;
-                            J = *rhs_iter;
-                        } else if (J.right_value() == rhs_iter->right_value() && J.right_bracket() == rhs_iter->right_bracket()) {
-                            if (++lhs_iter == lhs_end) { break; }
-                            I = *lhs_iter;
-                        } else {
-                            if (++rhs_iter == rhs_end) { break; }
-                            I = *rhs_iter;
-                        }
-                    }
+            template<BoundaryConcept RhsBoundary, std::size_t RhsCapacity, class RhsAllocator>
+            constexpr auto operator&&(const IntervalUnion<RhsBoundary, RhsCapacity, RhsAllocator>& rhs) const {
+                using CommonIntervalUnion = detail::common_interval_union_t<IntervalUnion, RhsBoundary>;
+                typename CommonIntervalUnion::allocator_type allocator(get_allocator());
+                if (isnan() || rhs.isnan()) { return CommonIntervalUnion::nan(allocator); }
+                CommonIntervalUnion intersection(allocator);
+                if (!isempty() && !rhs.isempty()) {
+                    intersection.intervals.reserve(intervals.size() + rhs.intervals.size() - 1);
+                    detail::intersect_sorted(intervals, rhs.intervals, [&](const auto& l, bool lc, const auto& r, bool rc) {
+                        intersection.intervals.push_back(l, lc, r, rc);
+                    });
                 }
                 return intersection;
             }
 
-            template<BoundaryConcept RhsBoundary>
-            auto operator||(const IntervalUnion<RhsBoundary>& rhs) const {
-                using CommonIntervalUnion = IntervalUnion<std::common_type_t<Boundary, RhsBoundary>>;
-                if (isnan() || rhs.isnan()) { return CommonIntervalUnion::nan(); }
-                CommonIntervalUnion set_union;
-                set_union.intervals.reserve(std::max(intervals.size(), rhs.intervals.size()));
-                auto lhs_iter = intervals.cbegin();
-                auto rhs_iter = rhs.intervals.cbegin();
-                while (lhs_iter != intervals.cend() && rhs_iter != rhs.intervals.cend()) {
-                    if (
-                        lhs_iter->left_value() < rhs_iter->left_value() ||
-                        lhs_iter->left_value() == rhs_iter->left_value() && lhs_iter->left_bracket() == '[' && rhs_iter->left_bracket() == '('
-                    ) {
-                        set_union.intervals.emplace_back(*lhs_iter++);
-                    } else {
-                        set_union.intervals.emplace_back(*rhs_iter++);
-                    }
-                }
-                set_union.intervals.insert(set_union.intervals.end(), lhs_iter, intervals.cend());
-                set_union.intervals.insert(set_union.intervals.end(), rhs_iter, rhs.intervals.cend());
-                set_union.canonicalise_sorted_unempty_intervals();
+            template<BoundaryConcept RhsBoundary, std::size_t RhsCapacity, class RhsAllocator>
+            constexpr auto operator||(const IntervalUnion<RhsBoundary, RhsCapacity, RhsAllocator>& rhs) const {
+                using CommonIntervalUnion = detail::common_interval_union_t<IntervalUnion, RhsBoundary>;
+                typename CommonIntervalUnion::allocator_type allocator(get_allocator());
+                if (isnan() || rhs.isnan()) { return CommonIntervalUnion::nan(allocator); }
+                CommonIntervalUnion set_union(allocator);
+                set_union.intervals.reserve(intervals.size() + rhs.intervals.size());
+                detail::merge_sorted(intervals, rhs.intervals, [&](const auto& l, bool lc, const auto& r, bool rc) {
+                    set_union.append_sorted_unempty_interval(l, lc, r, rc);
+                });
                 return set_union;
             }
 
-            template<BoundaryConcept RhsBoundary>
-            bool operator==(const IntervalUnion<RhsBoundary>& rhs) const {
+            // In-place counterparts of &&, || and operator-. The result is written over this union's own
+            // storage, which only grows when it is too small to hold the inputs side by side, and equals
+            // the result of the binary operator, NaN included. Each operator first moves this union's
+            // intervals up by the size of the other operand and then merges them back down; the merge
+            // never writes more pieces than it has read intervals, so it cannot overtake the intervals it
+            // has yet to read. When the other operand has the wider boundary type the binary operator's
+            // result is converted instead, which requires the wider type to convert to this one.
+
+            template<BoundaryConcept RhsBoundary, std::size_t RhsCapacity, class RhsAllocator>
+                requires std::constructible_from<Boundary, std::common_type_t<Boundary, RhsBoundary>>
+            constexpr IntervalUnion& operator&=(const IntervalUnion<RhsBoundary, RhsCapacity, RhsAllocator>& rhs) {
+                if constexpr (!std::is_same_v<std::common_type_t<Boundary, RhsBoundary>, Boundary>) {
+                    return *this = IntervalUnion(*this && rhs, get_allocator());
+                } else {
+                    if (isnan() || rhs.isnan()) { return *this = nan(get_allocator()); }
+                    if (is_same_object(rhs) || isempty()) { return *this; }
+                    if (rhs.isempty()) { return *this = empty(get_allocator()); }
+                    return intersect_in_place(rhs.intervals);
+                }
+            }
+
+            template<BoundaryConcept RhsBoundary, std::size_t RhsCapacity, class RhsAllocator>
+                requires std::constructible_from<Boundary, std::common_type_t<Boundary, RhsBoundary>>
+            constexpr IntervalUnion& operator|=(const IntervalUnion<RhsBoundary, RhsCapacity, RhsAllocator>& rhs) {
+                if constexpr (!std::is_same_v<std::common_type_t<Boundary, RhsBoundary>, Boundary>) {
+                    return *this = IntervalUnion(*this || rhs, get_allocator());
+                } else {
+                    if (isnan() || rhs.isnan()) { return *this = nan(get_allocator()); }
+                    if (is_same_object(rhs) || rhs.isempty()) { return *this; }
+                    search_index.reset();
+                    auto n = intervals.size();
+                    auto m = rhs.intervals.size();
+                    intervals.grow_front(m);
+                    std::size_t written = 0;
+                    detail::merge_sorted(
+                        detail::OffsetIntervals<vector_type>(intervals, m, n),
+                        rhs.intervals,
+                        [&](const auto& l, bool lc, const auto& r, bool rc) {
+                            if (written != 0 && detail::touches(intervals.right_value(written-1), intervals.right_closed(written-1), l, lc)) {
+                                if (detail::precedes_right(intervals.right_value(written-1), intervals.right_closed(written-1), r, rc)) {
+                                    intervals.set_right(written-1, r, rc);
+                                }
+                            } else {
+                                intervals.set_left(written, l, lc);
+                                intervals.set_right(written, r, rc);
+                                ++written;
+                            }
+                        }
+                    );
+                    intervals.truncate(written);
+                    return *this;
+                }
+            }
+
+            template<BoundaryConcept RhsBoundary, std::size_t RhsCapacity, class RhsAllocator>
+                requires std::constructible_from<Boundary, std::common_type_t<Boundary, RhsBoundary>>
+            constexpr IntervalUnion& operator-=(const IntervalUnion<RhsBoundary, RhsCapacity, RhsAllocator>& rhs) {
+                if constexpr (!std::is_same_v<std::common_type_t<Boundary, RhsBoundary>, Boundary>) {
+                    return *this = IntervalUnion(*this - rhs, get_allocator());
+                } else {
+                    if (isnan() || rhs.isnan()) { return *this = nan(get_allocator()); }
+                    if (is_same_object(rhs)) { return *this = empty(get_allocator()); }
+                    if (isempty()) { return *this; }
+                    bool extended_real_line = (*this)(boundary_traits<Boundary>::infinity()) || detail::contains_negative_infinity(intervals.left_value(0), intervals.left_closed(0));
+                    return intersect_in_place(
+                        detail::ComplementIntervals<IntervalVector<RhsBoundary, RhsCapacity, RhsAllocator>, RhsBoundary>(rhs.intervals, extended_real_line)
+                    );
+                }
+            }
+
+            template<BoundaryConcept RhsBoundary, std::size_t RhsCapacity, class RhsAllocator>
+            constexpr bool operator==(const IntervalUnion<RhsBoundary, RhsCapacity, RhsAllocator>& rhs) const {
                 if (isnan() || rhs.isnan() || intervals.size() != rhs.intervals.size()) {
                     return false;
                 } else {
                     for (decltype(intervals.size()) i = 0; i != intervals.size(); ++i) {
-                        if (intervals[i] != rhs.intervals[i]) return false;
+                        if (
+                            intervals.left_value(i) != rhs.intervals.left_value(i) ||
+                            intervals.right_value(i) != rhs.intervals.right_value(i) ||
+                            intervals.left_closed(i) != rhs.intervals.left_closed(i) ||
+                            intervals.right_closed(i) != rhs.intervals.right_closed(i)
+                        ) {
+                            return false;
+                        }
                     }
                 }
                 return true;
             }
 
-            template<BoundaryConcept RhsBoundary>
-            bool operator!=(const IntervalUnion<RhsBoundary>& rhs) const {
+            template<BoundaryConcept RhsBoundary, std::size_t RhsCapacity, class RhsAllocator>
+            constexpr bool operator!=(const IntervalUnion<RhsBoundary, RhsCapacity, RhsAllocator>& rhs) const {
                 if (isnan() || rhs.isnan()) {
                     return false;
                 } else {
@@ -508,108 +1009,229 @@ namespace libp {
             }
 
             template<BoundaryConcept BoundaryX>
-            Boundary operator()(const BoundaryX& x) const {
-                auto iter = std::lower_bound(
-                    intervals.cbegin(),
-                    intervals.cend(),
+            constexpr Boundary operator()(const BoundaryX& x) const {
+                if (auto index = search_index.get()) {
+                    return index->contains(x);
+                }
+                const auto a = intervals.arrays();
+                std::size_t i = std::lower_bound(
+                    a.right_values,
+                    a.right_values + a.size,
                     x,
-                    [](const Interval<Boundary>& I, const BoundaryX& y) {
-                        return I.right_value() < y;
+                    [](const Boundary& right_value, const BoundaryX& y) {
+                        return right_value < y;
                     }
-                );
-                return iter == intervals.cend() ? 0 : (*iter)(x);
+                ) - a.right_values;
+                return i == a.size ? false : detail::contains_at(a, i, x);
             }
 
-        private:
-            std::vector<Interval<Boundary>> intervals;
+            // Unions of at least this many intervals get a search index when a batched lookup is large
+            // enough to pay for building it.
+            static constexpr std::size_t search_index_threshold = std::size_t(1) << 14;
 
-            template<BoundaryConcept B>
-            static auto interval_intersection_right_remainder(const Interval<B>& I, const Interval<B>& J) {
-                auto interval_intersection = Interval<B>(
-                    (
-                        I.left_value() < J.left_value()  ? J.left_bracket() :
-                        I.left_value() == J.left_value() ? std::min(I.left_bracket(), J.left_bracket()) :
-                                                           I.left_bracket()
-                    ),
-                    std::max(I.left_value(), J.left_value()),
-                    std::min(I.right_value(), J.right_value()),
-                    (
-                        I.right_value() < J.right_value()  ? I.right_bracket() :
-                        I.right_value() == J.right_value() ? std::min(I.right_bracket(), J.right_bracket()) :
-                                                             J.right_bracket()
-                    )
-                );
+            void build_search_index(void) const {
+                // Builds the cache-friendly index used by operator() and contains, if it does not exist
+                // yet. Worth calling before many single-point lookups on a large union, which will not
+                // build it themselves. The index is discarded when the union changes.
+                if (!isempty()) { search_index.build(intervals.arrays()); }
+            }
+
+            // Batched membership. Element k of mask (bit k%64 of bits[k/64]) is set to whether xs[k] is in
+            // the union, with the bracket semantics of operator(). The mask must hold xs.size() elements and
+            // bits must hold ceil(xs.size()/64) words, of which the bits past xs.size() are cleared. Double
+            // and float points against a union of the same boundary type use AVX-512 or AVX2 kernels when
+            // the processor supports them, and every other combination runs a scalar loop. A union with a
+            // search index uses it instead, and a large union builds one for a batch big enough to pay
+            // for it.
+
+            void contains(std::span<const Boundary> xs, std::span<bool> mask) const {
+                contains<Boundary>(xs, mask);
+            }
 
-                auto right_remainder = [&]() {
-                    if (interval_intersection.isempty()) {
-                        return I.right_value() <= J.left_value() ? J : I;
+            template<BoundaryConcept BoundaryX>
+            void contains(std::span<const BoundaryX> xs, std::span<bool> mask) const {
+                contains_impl(xs.data(), std::min(xs.size(), mask.size()), mask.data());
+            }
+
+            void contains(std::span<const Boundary> xs, std::span<std::uint64_t> bits) const {
+                contains<Boundary>(xs, bits);
+            }
+
+            template<BoundaryConcept BoundaryX>
+            void contains(std::span<const BoundaryX> xs, std::span<std::uint64_t> bits) const {
+                contains_impl(xs.data(), std::min(xs.size(), 64*bits.size()), bits.data());
+            }
+
+            // The index that classify_sorted writes for a point in none of the intervals.
+            static constexpr std::size_t gap = std::numeric_limits<std::size_t>::max();
+
+            template<std::input_iterator Iter, std::sentinel_for<Iter> Sentinel, std::output_iterator<std::size_t> Out>
+            Out classify_sorted(Iter first, Sentinel last, Out out) const {
+                // Writes, for each point in [first, last), the index of the interval containing it, or gap.
+                // The points must be in non-decreasing order. The intervals and points are walked together,
+                // so each point is read once and no point is buffered. Runs of intervals lying wholly
+                // between two points are skipped with an exponential search, so that the cost is
+                // O(m log(n/m)) for m points sparse among n intervals and never worse than O(n + m).
+                const auto a = intervals.arrays();
+                std::size_t i = 0;
+                for (; first != last; ++first) {
+                    const auto& x = *first;
+                    if (i != a.size && a.right_values[i] < x) {
+                        std::size_t lo = i;
+                        std::size_t step = 1;
+                        while (lo + step < a.size && a.right_values[lo + step] < x) {
+                            lo += step;
+                            step *= 2;
+                        }
+                        auto hi = std::min(lo + step, a.size);
+                        i = std::lower_bound(
+                            a.right_values + lo + 1,
+                            a.right_values + hi,
+                            x,
+                            [](const Boundary& right_value, const auto& y) { return right_value < y; }
+                        ) - a.right_values;
                     }
-                    return Interval<B>(
-                        interval_intersection.right_bracket() == ')' ? '[' : '(',
-                        interval_intersection.right_value(),
-                        std::max(I.right_value(), J.right_value()),
-                        (
-                            I.right_value() < J.right_value()  ? J.right_bracket() :
-                            I.right_value() == J.right_value() ? std::max(I.right_bracket(), J.right_bracket()) :
-                                                                 I.right_bracket()
-                        )
-                    );
-                }();
-                return std::make_pair(interval_intersection, right_remainder);
+                    *out = i != a.size && detail::contains_at(a, i, x) ? i : gap;
+                    ++out;
+                }
+                return out;
             }
 
-            template<BoundaryConcept BoundaryI, BoundaryConcept BoundaryJ>
-            static bool canonicalise_interval_union(Interval<BoundaryI>& I, const Interval<BoundaryJ>& J) {
-                // If I and J are distinct, return true and leave I unchanged, otherwise return false and set I to IUJ.
+            template<std::ranges::input_range Points, std::output_iterator<std::size_t> Out>
+            Out classify_sorted(Points&& points, Out out) const {
+                return classify_sorted(std::ranges::begin(points), std::ranges::end(points), std::move(out));
+            }
 
-                if (
-                    (I.left_value() < J.right_value() && J.left_value() < I.right_value()) ||
-                    (I.right_value() == J.left_value() && (I.right_bracket() == ']' || J.left_bracket() == '[')) ||
-                    (J.right_value() == I.left_value() && (J.right_bracket() == ']' || I.left_bracket() == '['))
-                ) {
-                    I.left_bracket_m = (
-                        I.left_value() < J.left_value()  ? I.left_bracket() :
-                        I.left_value() == J.left_value() ? std::max(I.left_bracket(), J.left_bracket()) :
-                                                           J.left_bracket()
-                    );
-                    I.left_value_m = std::min(I.left_value(), J.left_value());
-                    
-                    I.right_bracket_m = (
-                        I.right_value() < J.right_value()  ? J.right_bracket() :
-                        I.right_value() == J.right_value() ? std::max(I.right_bracket(), J.right_bracket()) :
-                                                             I.right_bracket()
-                    );
-                    I.right_value_m = std::max(I.right_value(), J.right_value());
+        private:
+            vector_type intervals;
+            detail::SearchIndexCache<Boundary> search_index;
+
+            template<BoundaryConcept BoundaryX, class Out>
+            void contains_impl(const BoundaryX* xs, std::size_t count, Out* out) const {
+                const auto a = intervals.arrays();
+                auto index = search_index.get();
+                if (index == nullptr && a.size >= search_index_threshold && 32*count >= a.size) {
+                    index = &search_index.build(a);
+                }
+                if (index != nullptr) {
+                    detail::contains_indexed(*index, xs, count, out);
+                } else {
+                    detail::contains(a, xs, count, out, detail::supported_simd_level());
+                }
+            }
 
+            template<BoundaryConcept RhsBoundary, std::size_t RhsCapacity, class RhsAllocator>
+            constexpr bool is_same_object(const IntervalUnion<RhsBoundary, RhsCapacity, RhsAllocator>& rhs) const {
+                if constexpr (std::is_same_v<IntervalUnion, IntervalUnion<RhsBoundary, RhsCapacity, RhsAllocator>>) {
+                    return this == &rhs;
+                } else {
                     return false;
                 }
+            }
 
-                return true;
+            template<class Rhs>
+            constexpr IntervalUnion& intersect_in_place(const Rhs& rhs) {
+                // Intersects this non-NaN union with a canonical sequence that does not alias it. See
+                // operator&= for why writing over the moved intervals is safe.
+                search_index.reset();
+                auto n = intervals.size();
+                auto m = rhs.size();
+                intervals.grow_front(m);
+                std::size_t written = 0;
+                detail::intersect_sorted(
+                    detail::OffsetIntervals<vector_type>(intervals, m, n),
+                    rhs,
+                    [&](const auto& l, bool lc, const auto& r, bool rc) {
+                        intervals.set_left(written, l, lc);
+                        intervals.set_right(written, r, rc);
+                        ++written;
+                    }
+                );
+                intervals.truncate(written);
+                return *this;
+            }
+
+            template<class S, class T>
+            constexpr void append_sorted_unempty_interval(const S& left_value, bool left_closed, const T& right_value, bool right_closed) {
+                // Appends an unempty interval whose left boundary is no earlier than that of the last
+                // interval, merging the two when they overlap or touch so that the union stays canonical.
+                if (!intervals.empty()) {
+                    auto last = intervals.size() - 1;
+                    if (detail::touches(intervals.right_value(last), intervals.right_closed(last), left_value, left_closed)) {
+                        if (detail::precedes_right(intervals.right_value(last), intervals.right_closed(last), right_value, right_closed)) {
+                            intervals.set_right(last, right_value, right_closed);
+                        }
+                        return;
+                    }
+                }
+                intervals.push_back(left_value, left_closed, right_value, right_closed);
             }
 
-            void canonicalise_sorted_unempty_intervals(void) {                  
-                auto writing_iter = intervals.begin();
-                if (writing_iter != intervals.end()) {
-                    for (auto reading_iter = intervals.cbegin() + 1; reading_iter != intervals.cend(); ++reading_iter) {
-                        if (canonicalise_interval_union(*writing_iter, *reading_iter)) {
-                            *(++writing_iter) = *reading_iter;
+            constexpr void canonicalise_sorted_unempty_intervals(void) {
+                auto n = intervals.size();
+                if (n != 0) {
+                    decltype(n) writing_index = 0;
+                    for (decltype(n) reading_index = 1; reading_index != n; ++reading_index) {
+                        if (detail::touches(
+                            intervals.right_value(writing_index), intervals.right_closed(writing_index),
+                            intervals.left_value(reading_index), intervals.left_closed(reading_index)
+                        )) {
+                            if (detail::precedes_right(
+                                intervals.right_value(writing_index), intervals.right_closed(writing_index),
+                                intervals.right_value(reading_index), intervals.right_closed(reading_index)
+                            )) {
+                                intervals.set_right(
+                                    writing_index,
+                                    intervals.right_value(reading_index),
+                                    intervals.right_closed(reading_index)
+                                );
+                            }
+                        } else if (++writing_index != reading_index) {
+                            intervals.assign(writing_index, reading_index);
                         }
                     }
-                    intervals.erase(++writing_iter, intervals.end());
+                    intervals.truncate(writing_index + 1);
                 }
             }
 
-            void canonicalise_unempty_intervals(void) {
-                std::sort(
-                    intervals.begin(),
-                    intervals.end(),
-                    [](const Interval<Boundary>& I, const Interval<Boundary>& J) {
-                        return (
-                            I.left_value() < J.left_value() ||
-                            I.left_value() == J.left_value() && I.left_bracket() == '[' && J.left_bracket() == '('
+            constexpr void canonicalise_unempty_intervals(void) {
+                // Sorts by left boundary through a permutation of indices, so that the arrays are only
+                // gathered once, and skips the sort entirely when the intervals arrive in order.
+                auto n = intervals.size();
+                auto precedes = [this](std::size_t i, std::size_t j) {
+                    return detail::precedes_left(intervals.left_value(i), intervals.left_closed(i), intervals.left_value(j), intervals.left_closed(j));
+                };
+                bool sorted = true;
+                for (decltype(n) i = 1; i < n && sorted; ++i) {
+                    sorted = !precedes(i, i-1);
+                }
+                if (!sorted) {
+                    std::vector<std::size_t, typename std::allocator_traits<Allocator>::template rebind_alloc<std::size_t>> order(n, get_allocator());
+                    for (decltype(n) i = 0; i != n; ++i) { order[i] = i; }
+                    if constexpr (detail::cut_key_traits<Boundary>::enabled) {
+                        // Each left boundary and bracket read once into a key, and the keys sorted with
+                        // their indices, which break ties as a stable sort would.
+                        using key_type = decltype(detail::cut_key(Boundary(), false));
+                        using keyed_index = std::pair<key_type, std::size_t>;
+                        std::vector<keyed_index, typename std::allocator_traits<Allocator>::template rebind_alloc<keyed_index>> keys(n, get_allocator());
+                        for (decltype(n) i = 0; i != n; ++i) { keys[i] = {detail::cut_key(intervals.left_value(i), !intervals.left_closed(i)), i}; }
+                        std::sort(keys.begin(), keys.end());
+                        for (decltype(n) i = 0; i != n; ++i) { order[i] = keys[i].second; }
+                    } else if (std::is_constant_evaluated()) {
+                        // std::stable_sort is not constexpr, and ties in left boundary merge either way.
+                        std::sort(order.begin(), order.end(), precedes);
+                    } else {
+                        std::stable_sort(order.begin(), order.end(), precedes);
+                    }
+                    vector_type sorted_intervals(get_allocator()); sorted_intervals.reserve(n);
+                    for (auto i : order) {
+                        sorted_intervals.push_back(
+                            intervals.left_value(i), intervals.left_closed(i),
+                            intervals.right_value(i), intervals.right_closed(i)
                         );
                     }
-                );
+                    intervals.swap(sorted_intervals);
+                }
                 canonicalise_sorted_unempty_intervals();
             }
     };
@@ -625,42 +1247,200 @@ namespace libp {
     template<std::forward_iterator Iter>
     IntervalUnion(Iter, Iter) -> IntervalUnion<typename Iter::value_type::boundary_type>;
 
-    template<BoundaryConcept RhsBoundary>
-    IntervalUnion(const IntervalUnion<RhsBoundary>&) -> IntervalUnion<RhsBoundary>;
+    template<BoundaryConcept RhsBoundary, std::size_t RhsCapacity, class RhsAllocator>
+    IntervalUnion(const IntervalUnion<RhsBoundary, RhsCapacity, RhsAllocator>&) -> IntervalUnion<RhsBoundary, RhsCapacity, RhsAllocator>;
+
+    namespace pmr {
+        template<BoundaryConcept Boundary, std::size_t InlineCapacity = 2>
+        using IntervalUnion = libp::IntervalUnion<Boundary, InlineCapacity, std::pmr::polymorphic_allocator<Boundary>>;
+    }
+
+    namespace detail {
+
+        struct IntervalUnionAccess {
+            // Lets the free functions that build unions from many inputs read and write their storage.
+
+            template<BoundaryConcept Boundary, std::size_t InlineCapacity, class Allocator>
+            static constexpr const auto& intervals(const IntervalUnion<Boundary, InlineCapacity, Allocator>& A) { return A.intervals; }
+
+            template<BoundaryConcept Boundary, std::size_t InlineCapacity, class Allocator>
+            static constexpr auto& intervals(IntervalUnion<Boundary, InlineCapacity, Allocator>& A) { return A.intervals; }
+
+            template<BoundaryConcept Boundary, std::size_t InlineCapacity, class Allocator>
+            static constexpr void canonicalise_sorted_unempty_intervals(IntervalUnion<Boundary, InlineCapacity, Allocator>& A) {
+                A.canonicalise_sorted_unempty_intervals();
+            }
+
+            template<BoundaryConcept Boundary, std::size_t InlineCapacity, class Allocator>
+            static constexpr void canonicalise_unempty_intervals(IntervalUnion<Boundary, InlineCapacity, Allocator>& A) {
+                A.canonicalise_unempty_intervals();
+            }
+
+            template<BoundaryConcept Boundary, std::size_t InlineCapacity, class Allocator, class S, class T>
+            static constexpr void append_sorted_unempty_interval(IntervalUnion<Boundary, InlineCapacity, Allocator>& A, const S& left_value, bool left_closed, const T& right_value, bool right_closed) {
+                A.append_sorted_unempty_interval(left_value, left_closed, right_value, right_closed);
+            }
+        };
+
+        template<class T>
+        struct interval_union_boundary { };
+
+        template<BoundaryConcept Boundary, std::size_t InlineCapacity, class Allocator>
+        struct interval_union_boundary<IntervalUnion<Boundary, InlineCapacity, Allocator>> { using type = Boundary; };
+
+        template<class T>
+        using interval_union_boundary_t = typename interval_union_boundary<std::remove_cvref_t<T>>::type;
 
-    template<BoundaryConcept LhsBoundary, BoundaryConcept RhsBoundary>
-    auto operator-(const IntervalUnion<LhsBoundary>& lhs, const IntervalUnion<RhsBoundary>& rhs) {
-        constexpr auto inf = std::numeric_limits<LhsBoundary>::infinity();
-        return lhs && rhs.inv(lhs(inf) || lhs(-inf));
     }
 
-    template<BoundaryConcept LhsBoundary, BoundaryConcept RhsBoundary>
-    auto operator<=(const IntervalUnion<LhsBoundary>& lhs, const IntervalUnion<RhsBoundary>& rhs) {
-        return (lhs - rhs).isempty();
+    template<class Range>
+    concept IntervalUnionRange = std::ranges::input_range<Range> &&
+        std::is_lvalue_reference_v<std::ranges::range_reference_t<Range>> &&
+        requires { typename detail::interval_union_boundary_t<std::ranges::range_reference_t<Range>>; };
+
+    template<BoundaryConcept LhsBoundary, std::size_t LhsCapacity, class LhsAllocator, BoundaryConcept RhsBoundary, std::size_t RhsCapacity, class RhsAllocator>
+    constexpr auto operator-(const IntervalUnion<LhsBoundary, LhsCapacity, LhsAllocator>& lhs, const IntervalUnion<RhsBoundary, RhsCapacity, RhsAllocator>& rhs) {
+        // lhs && rhs.inv(true), reading the complement on demand instead of building it. The complement
+        // in the extended real line only differs from that in the real line at the infinities, which
+        // are in the difference exactly when they are in lhs and not rhs either way.
+        using CommonIntervalUnion = detail::common_interval_union_t<IntervalUnion<LhsBoundary, LhsCapacity, LhsAllocator>, RhsBoundary>;
+        using Access = detail::IntervalUnionAccess;
+        typename CommonIntervalUnion::allocator_type allocator(lhs.get_allocator());
+        if (lhs.isnan() || rhs.isnan()) { return CommonIntervalUnion::nan(allocator); }
+        CommonIntervalUnion difference(allocator);
+        if (!lhs.isempty()) {
+            const auto& lhs_intervals = Access::intervals(lhs);
+            detail::ComplementIntervals<IntervalVector<RhsBoundary, RhsCapacity, RhsAllocator>, RhsBoundary> complement(Access::intervals(rhs), true);
+            auto& intervals = Access::intervals(difference);
+            intervals.reserve(lhs_intervals.size() + complement.size());
+            detail::intersect_sorted(lhs_intervals, complement, [&](const auto& l, bool lc, const auto& r, bool rc) {
+                intervals.push_back(l, lc, r, rc);
+            });
+        }
+        return difference;
     }
 
-    template<BoundaryConcept LhsBoundary, BoundaryConcept RhsBoundary>
-    auto operator>=(const IntervalUnion<LhsBoundary>& lhs, const IntervalUnion<RhsBoundary>& rhs) {
+    // The predicates walk both operands once without allocating, and return as soon as they find a
+    // witness. Like the comparisons of the boundaries themselves, they are all false when either operand
+    // is NaN.
+
+    template<BoundaryConcept LhsBoundary, std::size_t LhsCapacity, class LhsAllocator, BoundaryConcept RhsBoundary, std::size_t RhsCapacity, class RhsAllocator>
+    constexpr bool operator<=(const IntervalUnion<LhsBoundary, LhsCapacity, LhsAllocator>& lhs, const IntervalUnion<RhsBoundary, RhsCapacity, RhsAllocator>& rhs) {
+        using Access = detail::IntervalUnionAccess;
+        return !lhs.isnan() && !rhs.isnan() && detail::is_subset_sorted(Access::intervals(lhs), Access::intervals(rhs));
+    }
+
+    template<BoundaryConcept LhsBoundary, std::size_t LhsCapacity, class LhsAllocator, BoundaryConcept RhsBoundary, std::size_t RhsCapacity, class RhsAllocator>
+    constexpr bool operator>=(const IntervalUnion<LhsBoundary, LhsCapacity, LhsAllocator>& lhs, const IntervalUnion<RhsBoundary, RhsCapacity, RhsAllocator>& rhs) {
         return rhs <= lhs;
     }
 
-    template<BoundaryConcept LhsBoundary, BoundaryConcept RhsBoundary>
-    auto operator<(const IntervalUnion<LhsBoundary>& lhs, const IntervalUnion<RhsBoundary>& rhs) {
-        return (lhs <= rhs) && !(lhs >= rhs);
+    template<BoundaryConcept LhsBoundary, std::size_t LhsCapacity, class LhsAllocator, BoundaryConcept RhsBoundary, std::size_t RhsCapacity, class RhsAllocator>
+    constexpr bool operator<(const IntervalUnion<LhsBoundary, LhsCapacity, LhsAllocator>& lhs, const IntervalUnion<RhsBoundary, RhsCapacity, RhsAllocator>& rhs) {
+        // Canonical unions are equal exactly when their intervals are, so a subset is strict when the
+        // intervals differ.
+        return lhs <= rhs && lhs != rhs;
     }
 
-    template<BoundaryConcept LhsBoundary, BoundaryConcept RhsBoundary>
-    auto operator>(const IntervalUnion<LhsBoundary>& lhs, const IntervalUnion<RhsBoundary>& rhs) {
+    template<BoundaryConcept LhsBoundary, std::size_t LhsCapacity, class LhsAllocator, BoundaryConcept RhsBoundary, std::size_t RhsCapacity, class RhsAllocator>
+    constexpr bool operator>(const IntervalUnion<LhsBoundary, LhsCapacity, LhsAllocator>& lhs, const IntervalUnion<RhsBoundary, RhsCapacity, RhsAllocator>& rhs) {
         return rhs < lhs;
     }
 
-    template<BoundaryConcept LhsBoundary, BoundaryConcept RhsBoundary>
-    auto isdisjoint(const IntervalUnion<LhsBoundary>& lhs, const IntervalUnion<RhsBoundary>& rhs) {
-        return (lhs && rhs).isempty()
+    template<BoundaryConcept LhsBoundary, std::size_t LhsCapacity, class LhsAllocator, BoundaryConcept RhsBoundary, std::size_t RhsCapacity, class RhsAllocator>
+    constexpr bool isdisjoint(const IntervalUnion<LhsBoundary, LhsCapacity, LhsAllocator>& lhs, const IntervalUnion<RhsBoundary, RhsCapacity, RhsAllocator>& rhs) {
+        using Access = detail::IntervalUnionAccess;
+        return !lhs.isnan() && !rhs.isnan() && detail::is_disjoint_sorted(Access::intervals(lhs), Access::intervals(rhs));
     }
 
-    template<BoundaryConcept Boundary>
-    std::ostream& operator<<(std::ostream& os, const libp::IntervalUnion<Boundary>& A) {
+    template<BoundaryConcept LhsBoundary, std::size_t LhsCapacity, class LhsAllocator, BoundaryConcept RhsBoundary, std::size_t RhsCapacity, class RhsAllocator>
+    constexpr bool overlaps(const IntervalUnion<LhsBoundary, LhsCapacity, LhsAllocator>& lhs, const IntervalUnion<RhsBoundary, RhsCapacity, RhsAllocator>& rhs) {
+        return !lhs.isnan() && !rhs.isnan() && !isdisjoint(lhs, rhs);
+    }
+
+    // Union and intersection of every union in a range, computed in one pass over all of their
+    // intervals instead of a chain of binary operators that re-merges the growing result each time. Both
+    // take O(total log k) time for k unions holding total intervals between them, and return NaN if any
+    // input is NaN. The union of no unions is empty and their intersection is the extended real line,
+    // the identities of || and &&.
+
+    template<IntervalUnionRange Unions>
+    auto union_all(Unions&& unions) {
+        using Union = std::remove_cvref_t<std::ranges::range_reference_t<Unions>>;
+        using Boundary = typename Union::boundary_type;
+        using Access = detail::IntervalUnionAccess;
+        std::vector<const typename Union::vector_type*> inputs;
+        std::size_t total = 0;
+        std::optional<typename Union::allocator_type> allocator;
+        for (const Union& A : unions) {
+            if (!allocator) { allocator.emplace(A.get_allocator()); }
+            if (A.isnan()) { return Union::nan(*allocator); }
+            if (!A.isempty()) {
+                inputs.push_back(&Access::intervals(A));
+                total += inputs.back()->size();
+            }
+        }
+
+        // Heap merge by left boundary, keeping the next interval of every input in the heap along with
+        // its left boundary, so that sifting does not chase pointers into the inputs. The merged
+        // intervals are sorted but overlap wherever the inputs do, which a single canonicalising pass
+        // then resolves.
+        struct Cursor { detail::Cut<Boundary> left; std::size_t input; std::size_t i; };
+        auto later = [](const Cursor& a, const Cursor& b) { return b.left < a.left; };
+        std::vector<Cursor> heap; heap.reserve(inputs.size());
+        for (std::size_t input = 0; input != inputs.size(); ++input) {
+            const auto& A = *inputs[input];
+            heap.push_back({detail::Cut<Boundary>::left(A.left_value(0), A.left_closed(0)), input, 0});
+        }
+        std::make_heap(heap.begin(), heap.end(), later);
+
+        Union set_union(allocator.value_or(typename Union::allocator_type()));
+        auto& intervals = Access::intervals(set_union);
+        intervals.reserve(total);
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), later);
+            auto& cursor = heap.back();
+            const auto& A = *inputs[cursor.input];
+            intervals.push_back(A.left_value(cursor.i), A.left_closed(cursor.i), A.right_value(cursor.i), A.right_closed(cursor.i));
+            if (++cursor.i != A.size()) {
+                cursor.left = detail::Cut<Boundary>::left(A.left_value(cursor.i), A.left_closed(cursor.i));
+                std::push_heap(heap.begin(), heap.end(), later);
+            } else {
+                heap.pop_back();
+            }
+        }
+        Access::canonicalise_sorted_unempty_intervals(set_union);
+        return set_union;
+    }
+
+    template<IntervalUnionRange Unions>
+    auto intersect_all(Unions&& unions) {
+        using Union = std::remove_cvref_t<std::ranges::range_reference_t<Unions>>;
+        using Boundary = typename Union::boundary_type;
+        using Access = detail::IntervalUnionAccess;
+        std::vector<const typename Union::vector_type*> inputs;
+        bool any_empty = false;
+        std::optional<typename Union::allocator_type> allocator;
+        for (const Union& A : unions) {
+            if (!allocator) { allocator.emplace(A.get_allocator()); }
+            if (A.isnan()) { return Union::nan(*allocator); }
+            any_empty = any_empty || A.isempty();
+            inputs.push_back(&Access::intervals(A));
+        }
+        if (inputs.empty()) { return Union::universal(true); }
+
+        Union intersection(*allocator);
+        if (!any_empty) {
+            auto& intervals = Access::intervals(intersection);
+            detail::covered_by_at_least<Boundary>(inputs, inputs.size(), [&](const auto& l, bool lc, const auto& r, bool rc) {
+                intervals.push_back(l, lc, r, rc);
+            });
+        }
+        return intersection;
+    }
+
+    template<BoundaryConcept Boundary, std::size_t InlineCapacity, class Allocator>
+    std::ostream& operator<<(std::ostream& os, const libp::IntervalUnion<Boundary, InlineCapacity, Allocator>& A) {
         if (A.isempty()) {
             os << libp::Interval<Boundary>('(',0,0,')');
         } else {
@@ -672,8 +1452,8 @@ namespace libp {
         return os;
     }
 
-    template<BoundaryConcept Boundary>
-    std::istream& operator>>(std::istream& is, libp::IntervalUnion<Boundary>& A) {
+    template<BoundaryConcept Boundary, std::size_t InlineCapacity, class Allocator>
+    std::istream& operator>>(std::istream& is, libp::IntervalUnion<Boundary, InlineCapacity, Allocator>& A) {
         std::vector<libp::Interval<Boundary>> intervals;
         bool isnan = false;
         for (libp::Interval<Boundary> I; is >> I; ) {
@@ -688,7 +1468,7 @@ namespace libp {
             }
         }
 
-        auto populate_A = [&]() { libp::IntervalUnion<Boundary> B(intervals.cbegin(), intervals.cend()); std::swap(A,B); };
+        auto populate_A = [&]() { libp::IntervalUnion<Boundary, InlineCapacity, Allocator> B(intervals.cbegin(), intervals.cend(), A.get_allocator()); std::swap(A,B); };
 
         if (is.eof()) {
             populate_A();
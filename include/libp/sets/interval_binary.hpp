@@ -0,0 +1,209 @@
+#ifndef LIBP_SETS_INTERVAL_BINARY_HPP_GUARD
+#define LIBP_SETS_INTERVAL_BINARY_HPP_GUARD
+
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <system_error>
+#include <type_traits>
+
+#include <libp/sets/interval.hpp>
+
+namespace libp {
+
+    // A compact binary format for unions of float or double boundaries. Every field is little-endian:
+    //
+    //     offset  size        field
+    //     0       4           magic, the characters LPIU
+    //     4       2           format version, currently 1
+    //     6       1           boundary size in bytes: 4 for IEEE binary32 (float), 8 for binary64 (double)
+    //     7       1           flags: bit 0 is set for the NaN union, which has no intervals
+    //     8       8           number of intervals n
+    //     16      n*size      left boundaries
+    //             n*size      right boundaries
+    //             8*ceil(n/64) left bracket words: bit i%64 of word i/64 is set when interval i is closed
+    //             8*ceil(n/64) right bracket words
+    //
+    // which is the in-memory layout of a union, so that on a little-endian machine writing and reading
+    // a union whose boundary type matches the file copy each array in one memcpy. Either boundary size
+    // can be read into either type. The functions follow std::to_chars and std::from_chars: results hold
+    // the end of the bytes written or read and an error code, and on error the destination is left
+    // unchanged.
+
+    template<class Boundary>
+    concept BinaryBoundaryConcept = std::same_as<Boundary, float> || std::same_as<Boundary, double>;
+
+    struct BinaryWriteResult {
+        std::byte* ptr;
+        std::errc ec;
+    };
+
+    struct BinaryReadResult {
+        const std::byte* ptr;
+        std::errc ec;
+    };
+
+    namespace detail {
+
+        inline constexpr char binary_magic[4] = {'L', 'P', 'I', 'U'};
+        inline constexpr std::uint16_t binary_version = 1;
+        inline constexpr std::size_t binary_header_size = 16;
+
+        constexpr std::size_t binary_words_for(std::uint64_t n) { return (n + 63)/64; }
+
+        template<std::unsigned_integral T>
+        void store_little(std::byte* out, T x) {
+            for (std::size_t k = 0; k != sizeof(T); ++k) { out[k] = std::byte((x >> (8*k)) & 0xff); }
+        }
+
+        template<std::unsigned_integral T>
+        T load_little(const std::byte* in) {
+            T x = 0;
+            for (std::size_t k = 0; k != sizeof(T); ++k) { x |= T(std::to_integer<unsigned char>(in[k])) << (8*k); }
+            return x;
+        }
+
+        template<class T>
+        using binary_bits_t = std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+
+        template<class T>
+        void store_array(std::byte* out, const T* values, std::size_t n) {
+            // Writes n values as little-endian, in one copy when that is their layout in memory.
+            if constexpr (std::endian::native == std::endian::little) {
+                if (n != 0) { std::memcpy(out, values, n*sizeof(T)); }
+            } else {
+                for (std::size_t i = 0; i != n; ++i) { store_little(out + i*sizeof(T), std::bit_cast<binary_bits_t<T>>(values[i])); }
+            }
+        }
+
+        struct BinaryHeader {
+            std::size_t boundary_size;
+            bool nan;
+            std::uint64_t n;
+            std::size_t words;
+            const std::byte* end;
+        };
+
+        inline std::errc read_binary_header(const std::byte* first, const std::byte* last, BinaryHeader& header) {
+            // Checks the header and that the arrays it describes fit before last, with the error codes
+            // of read_binary.
+            std::size_t available = last - first;
+            if (available < binary_header_size || std::memcmp(first, binary_magic, 4) != 0) { return std::errc::invalid_argument; }
+            auto version = load_little<std::uint16_t>(first + 4);
+            auto boundary_size = std::to_integer<std::size_t>(first[6]);
+            auto flags = std::to_integer<unsigned>(first[7]);
+            auto n = load_little<std::uint64_t>(first + 8);
+            if (version > binary_version || (boundary_size != 4 && boundary_size != 8)) { return std::errc::not_supported; }
+            if (version == 0 || (flags & ~1u) != 0 || ((flags & 1) && n != 0)) { return std::errc::invalid_argument; }
+            std::size_t words = binary_words_for(n);
+            if (n > (available - binary_header_size)/(2*boundary_size) ||
+                available - binary_header_size - 2*n*boundary_size < 16*words) {
+                return std::errc::invalid_argument;
+            }
+            header = {boundary_size, (flags & 1) != 0, n, words, first + binary_header_size + 2*n*boundary_size + 16*words};
+            return std::errc();
+        }
+
+        template<class Stored, class T>
+        void load_array(const std::byte* in, T* values, std::size_t n) {
+            // Reads n little-endian values of type Stored into values, in one copy when no conversion
+            // is needed.
+            if constexpr (std::endian::native == std::endian::little && std::is_same_v<Stored, T>) {
+                if (n != 0) { std::memcpy(values, in, n*sizeof(T)); }
+            } else {
+                for (std::size_t i = 0; i != n; ++i) {
+                    values[i] = T(std::bit_cast<Stored>(load_little<binary_bits_t<Stored>>(in + i*sizeof(Stored))));
+                }
+            }
+        }
+
+    }
+
+    template<BinaryBoundaryConcept Boundary, std::size_t InlineCapacity, class Allocator>
+    std::size_t binary_size(const IntervalUnion<Boundary, InlineCapacity, Allocator>& A) {
+        // The number of bytes write_binary writes for A.
+        std::size_t n = A.isnan() ? 0 : detail::IntervalUnionAccess::intervals(A).size();
+        return detail::binary_header_size + 2*n*sizeof(Boundary) + 16*detail::binary_words_for(n);
+    }
+
+    template<BinaryBoundaryConcept Boundary, std::size_t InlineCapacity, class Allocator>
+    BinaryWriteResult write_binary(std::byte* first, std::byte* last, const IntervalUnion<Boundary, InlineCapacity, Allocator>& A) {
+        // Reports std::errc::value_too_large when fewer than binary_size(A) bytes are available.
+        if (std::size_t(last - first) < binary_size(A)) { return {last, std::errc::value_too_large}; }
+        const auto& intervals = detail::IntervalUnionAccess::intervals(A);
+        std::uint64_t n = A.isnan() ? 0 : intervals.size();
+        std::size_t words = detail::binary_words_for(n);
+        const auto a = intervals.arrays();
+
+        std::memcpy(first, detail::binary_magic, 4);
+        detail::store_little<std::uint16_t>(first + 4, detail::binary_version);
+        first[6] = std::byte(sizeof(Boundary));
+        first[7] = std::byte(A.isnan() ? 1 : 0);
+        detail::store_little<std::uint64_t>(first + 8, n);
+        std::byte* p = first + detail::binary_header_size;
+        detail::store_array(p, a.left_values, n); p += n*sizeof(Boundary);
+        detail::store_array(p, a.right_values, n); p += n*sizeof(Boundary);
+        detail::store_array(p, a.left_closed, words); p += 8*words;
+        detail::store_array(p, a.right_closed, words); p += 8*words;
+        return {p, std::errc()};
+    }
+
+    template<BinaryBoundaryConcept Boundary, std::size_t InlineCapacity, class Allocator>
+    BinaryReadResult read_binary(const std::byte* first, const std::byte* last, IntervalUnion<Boundary, InlineCapacity, Allocator>& A, bool trusted = false) {
+        // Reads one union. Unless trusted is set, the intervals are checked to hold no NaN boundary and
+        // canonicalised as IntervalUnion(first, last) would, so that any well-formed file gives a valid
+        // union; trusted skips this for data known to come from write_binary of a union with the same
+        // boundary type. Reports std::errc::not_supported for a later format version or an unknown
+        // boundary size, and std::errc::invalid_argument for anything else that is not a valid file,
+        // including one cut short.
+        using Access = detail::IntervalUnionAccess;
+        detail::BinaryHeader header;
+        if (auto ec = detail::read_binary_header(first, last, header); ec != std::errc()) { return {first, ec}; }
+        auto [boundary_size, nan, n, words, end] = header;
+
+        if (nan) {
+            A = IntervalUnion<Boundary, InlineCapacity, Allocator>::nan(A.get_allocator());
+            return {end, std::errc()};
+        }
+
+        IntervalUnion<Boundary, InlineCapacity, Allocator> B(A.get_allocator());
+        auto& intervals = Access::intervals(B);
+        intervals.resize_for_overwrite(n);
+        const std::byte* p = first + detail::binary_header_size;
+        if (boundary_size == 4) {
+            detail::load_array<float>(p, intervals.left_values_data(), n);
+            detail::load_array<float>(p + n*4, intervals.right_values_data(), n);
+        } else {
+            detail::load_array<double>(p, intervals.left_values_data(), n);
+            detail::load_array<double>(p + n*8, intervals.right_values_data(), n);
+        }
+        p += 2*n*boundary_size;
+        detail::load_array<std::uint64_t>(p, intervals.left_closed_words(), words);
+        detail::load_array<std::uint64_t>(p + 8*words, intervals.right_closed_words(), words);
+        if (auto tail = n % 64; tail != 0) {
+            intervals.left_closed_words()[words - 1] &= (std::uint64_t(1) << tail) - 1;
+            intervals.right_closed_words()[words - 1] &= (std::uint64_t(1) << tail) - 1;
+        }
+
+        if (!trusted || boundary_size != sizeof(Boundary)) {
+            std::size_t kept = 0;
+            for (std::size_t i = 0; i != n; ++i) {
+                Interval<Boundary> I = intervals[i];
+                if (std::isnan(I.left_value()) || std::isnan(I.right_value())) { return {first, std::errc::invalid_argument}; }
+                if (!I.isempty()) {
+                    intervals.assign(kept++, i);
+                }
+            }
+            intervals.truncate(kept);
+            Access::canonicalise_unempty_intervals(B);
+        }
+        A = std::move(B);
+        return {end, std::errc()};
+    }
+
+}
+
+#endif
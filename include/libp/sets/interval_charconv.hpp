@@ -0,0 +1,243 @@
+#ifndef LIBP_SETS_INTERVAL_CHARCONV_HPP_GUARD
+#define LIBP_SETS_INTERVAL_CHARCONV_HPP_GUARD
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <system_error>
+
+#if __has_include(<format>)
+#include <format>
+#endif
+
+#include <libp/sets/interval.hpp>
+
+namespace libp {
+
+    // Writing and parsing of the text of operator<< and operator>>, over character ranges in memory
+    // rather than streams. The writers produce the format of operator<<, with every boundary written by
+    // std::to_chars in the shortest form that reads back to the same value, so that parsing what they
+    // write gives back the same set and writing it again gives back the same characters. Neither
+    // direction allocates or depends on the locale.
+    //
+    // The parsers take the grammar of operator>>: whitespace may separate any two tokens, an interval is
+    // a bracket, a boundary, a comma, a boundary and a bracket, a boundary is a decimal number, inf,
+    // -inf or nan, and a union is a run of intervals ended by ';' or by the end of the input. As for
+    // std::to_chars and std::from_chars, the results hold the end of the characters written or
+    // consumed. A writer reports std::errc::value_too_large when the range is too short, and a parser
+    // reports std::errc::invalid_argument when the input does not start with a valid interval or
+    // union, in which case the destination is left unchanged.
+
+    namespace detail {
+
+        inline const char* skip_whitespace(const char* first, const char* last) {
+            while (first != last && (*first == ' ' || (*first >= '\t' && *first <= '\r'))) { ++first; }
+            return first;
+        }
+
+        inline const char* match_text(const char* first, const char* last, const char* text) {
+            // The end of text if [first, last) starts with it, otherwise nullptr.
+            for (; *text != '\0'; ++first, ++text) {
+                if (first == last || *first != *text) { return nullptr; }
+            }
+            return first;
+        }
+
+        template<std::floating_point Boundary>
+        const char* parse_boundary(const char* first, const char* last, Boundary& b) {
+            // Reads one boundary after any whitespace, returning the end of it, or nullptr on failure.
+            first = skip_whitespace(first, last);
+            if (first == last) { return nullptr; }
+            const char* p = first;
+            bool negative = p != last && *p == '-';
+            if (p != last && (*p == '-' || *p == '+')) { ++p; }
+            if (p != last && (*p == 'i' || *p == 'n')) {
+                // from_chars would also take INF, infinity and nan(...), which operator>> rejects.
+                if (const char* end = match_text(p, last, "inf")) {
+                    b = negative ? -std::numeric_limits<Boundary>::infinity() : std::numeric_limits<Boundary>::infinity();
+                    return *first == '+' ? nullptr : end;
+                }
+                if (const char* end = match_text(p, last, "nan"); end && p == first) {
+                    b = std::numeric_limits<Boundary>::quiet_NaN();
+                    return end;
+                }
+                return nullptr;
+            }
+            if (p != first && *first == '+' && (p == last || *p == '-')) { return nullptr; }
+            Boundary value;
+            auto [end, ec] = std::from_chars(*first == '+' ? p : first, last, value, std::chars_format::general);
+            if (ec != std::errc()) { return nullptr; }
+            b = value;
+            return end;
+        }
+
+        template<std::floating_point Boundary>
+        char* write_boundary(char* first, char* last, const Boundary& b) {
+            // Writes one boundary, returning the end of it, or nullptr when it does not fit. NaN is
+            // written as nan whatever its sign, as operator>> reads it.
+            if (std::isnan(b)) {
+                if (last - first < 3) { return nullptr; }
+                return std::copy_n("nan", 3, first);
+            }
+            auto [end, ec] = std::to_chars(first, last, b);
+            return ec == std::errc() ? end : nullptr;
+        }
+
+        template<std::floating_point Boundary>
+        char* write_interval(char* first, char* last, const Interval<Boundary>& I) {
+            if (first == last) { return nullptr; }
+            *first++ = I.left_bracket();
+            if (!(first = write_boundary(first, last, I.left_value())) || first == last) { return nullptr; }
+            *first++ = ',';
+            if (!(first = write_boundary(first, last, I.right_value())) || first == last) { return nullptr; }
+            *first++ = I.right_bracket();
+            return first;
+        }
+
+        // Enough characters for any interval: two brackets, a comma, and two boundaries of at most a
+        // sign, max_digits10 digits, a point, and an exponent of a letter, a sign and up to five digits.
+        template<std::floating_point Boundary>
+        inline constexpr std::size_t interval_chars = 3 + 2*(std::numeric_limits<Boundary>::max_digits10 + 9);
+
+        template<std::floating_point Boundary>
+        const char* parse_interval(const char* first, const char* last, Interval<Boundary>& I) {
+            first = skip_whitespace(first, last);
+            if (first == last || (*first != '(' && *first != '[')) { return nullptr; }
+            char left_bracket = *first++;
+            Boundary left_value;
+            if (!(first = parse_boundary(first, last, left_value))) { return nullptr; }
+            first = skip_whitespace(first, last);
+            if (first == last || *first++ != ',') { return nullptr; }
+            Boundary right_value;
+            if (!(first = parse_boundary(first, last, right_value))) { return nullptr; }
+            first = skip_whitespace(first, last);
+            if (first == last || (*first != ')' && *first != ']')) { return nullptr; }
+            char right_bracket = *first++;
+            I = Interval<Boundary>(left_bracket, left_value, right_value, right_bracket);
+            return first;
+        }
+
+    }
+
+    template<std::floating_point Boundary>
+    std::to_chars_result to_chars(char* first, char* last, const Interval<Boundary>& I) {
+        if (char* end = detail::write_interval(first, last, I)) { return {end, std::errc()}; }
+        return {last, std::errc::value_too_large};
+    }
+
+    template<std::floating_point Boundary, std::size_t InlineCapacity, class Allocator>
+    std::to_chars_result to_chars(char* first, char* last, const IntervalUnion<Boundary, InlineCapacity, Allocator>& A) {
+        // The intervals followed by ';', with the empty union written as (0,0);. On failure, the
+        // characters in [first, last) are unspecified.
+        char* p = first;
+        if (A.isempty()) {
+            p = detail::write_interval(p, last, Interval<Boundary>::empty());
+        } else {
+            for (auto iter = A.cbegin(); iter != A.cend() && p; ++iter) {
+                p = detail::write_interval(p, last, *iter);
+            }
+        }
+        if (!p || p == last) { return {last, std::errc::value_too_large}; }
+        *p++ = ';';
+        return {p, std::errc()};
+    }
+
+    template<std::floating_point Boundary>
+    std::from_chars_result from_chars(const char* first, const char* last, Interval<Boundary>& I) {
+        if (const char* end = detail::parse_interval(first, last, I)) { return {end, std::errc()}; }
+        return {first, std::errc::invalid_argument};
+    }
+
+    template<std::floating_point Boundary, std::size_t InlineCapacity, class Allocator>
+    std::from_chars_result from_chars(const char* first, const char* last, IntervalUnion<Boundary, InlineCapacity, Allocator>& A) {
+        // Intervals are appended straight to the result's storage, which is sorted and merged only when
+        // they do not arrive in canonical order. As for operator>>, a NaN interval makes the union NaN and
+        // the intervals after it are still read.
+        using Access = detail::IntervalUnionAccess;
+        IntervalUnion<Boundary, InlineCapacity, Allocator> B(A.get_allocator());
+        auto& intervals = Access::intervals(B);
+        bool isnan = false;
+        bool any = false;
+        const char* p = first;
+        for (Interval<Boundary> I; const char* end = detail::parse_interval(p, last, I); p = end) {
+            any = true;
+            if (isnan) { continue; }
+            if (I.isnan()) {
+                isnan = true;
+                intervals.clear();
+                intervals.push_back(I);
+            } else if (!I.isempty()) {
+                intervals.push_back(I);
+            }
+        }
+        p = detail::skip_whitespace(p, last);
+        if (p != last && *p == ';') {
+            ++p;
+        } else if (p != last || !any) {
+            return {first, std::errc::invalid_argument};
+        }
+        if (!isnan) { Access::canonicalise_unempty_intervals(B); }
+        A = std::move(B);
+        return {p, std::errc()};
+    }
+
+}
+
+#if defined(__cpp_lib_format)
+
+// Formatting with std::format and friends, in the text of to_chars. The format specification must be
+// empty, as in "{}".
+
+namespace std {
+
+    template<std::floating_point Boundary>
+    struct formatter<libp::Interval<Boundary>, char> {
+        constexpr auto parse(std::format_parse_context& ctx) {
+            auto iter = ctx.begin();
+            if (iter != ctx.end() && *iter != '}') { throw std::format_error("invalid format specification for libp::Interval"); }
+            return iter;
+        }
+
+        template<class FormatContext>
+        auto format(const libp::Interval<Boundary>& I, FormatContext& ctx) const {
+            char buffer[libp::detail::interval_chars<Boundary>];
+            auto [end, ec] = libp::to_chars(buffer, buffer + sizeof(buffer), I);
+            return std::copy(buffer, end, ctx.out());
+        }
+    };
+
+    template<std::floating_point Boundary, std::size_t InlineCapacity, class Allocator>
+    struct formatter<libp::IntervalUnion<Boundary, InlineCapacity, Allocator>, char> {
+        constexpr auto parse(std::format_parse_context& ctx) {
+            auto iter = ctx.begin();
+            if (iter != ctx.end() && *iter != '}') { throw std::format_error("invalid format specification for libp::IntervalUnion"); }
+            return iter;
+        }
+
+        template<class FormatContext>
+        auto format(const libp::IntervalUnion<Boundary, InlineCapacity, Allocator>& A, FormatContext& ctx) const {
+            // Formats an interval at a time, so that no buffer proportional to the union is needed.
+            char buffer[libp::detail::interval_chars<Boundary>];
+            auto out = ctx.out();
+            auto write = [&](const libp::Interval<Boundary>& I) {
+                auto [end, ec] = libp::to_chars(buffer, buffer + sizeof(buffer), I);
+                out = std::copy(buffer, end, out);
+            };
+            if (A.isempty()) {
+                write(libp::Interval<Boundary>::empty());
+            } else {
+                for (auto iter = A.cbegin(); iter != A.cend(); ++iter) { write(*iter); }
+            }
+            *out++ = ';';
+            return out;
+        }
+    };
+
+}
+
+#endif
+
+#endif
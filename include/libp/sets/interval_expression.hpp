@@ -0,0 +1,355 @@
+#ifndef LIBP_SETS_INTERVAL_EXPRESSION_HPP_GUARD
+#define LIBP_SETS_INTERVAL_EXPRESSION_HPP_GUARD
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include <libp/sets/interval.hpp>
+#include <libp/sets/detail/interval_merge.hpp>
+
+namespace libp {
+
+    // Lazy set expressions. lazy(A) wraps a union without copying it, and the operators !, &&, || and -
+    // and inv() on wrapped unions build an expression tree instead of a result. Converting the tree to an
+    // IntervalUnion evaluates it in one pass that streams every operand's intervals through the tree and
+    // writes the canonical result straight into the destination, so
+    //
+    //     IntervalUnion<double> D = (lazy(A) && !lazy(B)) || lazy(C);
+    //
+    // allocates only D, where the eager operators would also allocate !B and A && !B. An expression
+    // refers to the unions it was built from, which must outlive it. The result has the boundary type
+    // common to all of them, and is NaN if any of them is NaN.
+
+    namespace detail {
+
+        template<class Boundary>
+        struct Piece {
+            // An unempty interval given by its two cuts.
+            Cut<Boundary> start;
+            Cut<Boundary> end;
+        };
+
+        template<class Boundary, class T>
+        Cut<Boundary> convert_cut(const Cut<T>& cut) {
+            return {convert_boundary<Boundary>(cut.value), cut.after};
+        }
+
+        template<class Derived>
+        class SetExpression {
+            // Every node yields its canonical pieces in order through start() and next(piece). Evaluation
+            // works on a copy of the tree, so an expression can be evaluated any number of times.
+
+            public:
+                auto inv(bool extended_real_line = false) const;
+
+                auto operator!() const {
+                    return inv(derived().contains_infinity(false) || derived().contains_infinity(true));
+                }
+
+                // The pieces are written as they come, so the destination must be discrete exactly when
+                // the expression is; convert the result of eval() otherwise.
+                template<BoundaryConcept Boundary, std::size_t InlineCapacity, class Allocator>
+                    requires std::constructible_from<Boundary, typename Derived::boundary_type> &&
+                        (boundary_traits<Boundary>::discrete == boundary_traits<typename Derived::boundary_type>::discrete)
+                operator IntervalUnion<Boundary, InlineCapacity, Allocator>() const {
+                    return evaluate<IntervalUnion<Boundary, InlineCapacity, Allocator>>(Allocator());
+                }
+
+                auto eval(void) const { return operator IntervalUnion<typename Derived::boundary_type>(); }
+
+                template<class Allocator>
+                auto eval(const Allocator& allocator) const {
+                    // Evaluates into a union allocating from allocator, such as a std::pmr::polymorphic_allocator.
+                    using Boundary = typename Derived::boundary_type;
+                    using Rebound = typename std::allocator_traits<Allocator>::template rebind_alloc<Boundary>;
+                    return evaluate<IntervalUnion<Boundary, 2, Rebound>>(Rebound(allocator));
+                }
+
+            private:
+                const Derived& derived(void) const { return static_cast<const Derived&>(*this); }
+
+                template<class Union>
+                Union evaluate(const typename Union::allocator_type& allocator) const {
+                    using Boundary = typename Union::boundary_type;
+                    if (derived().isnan()) { return Union::nan(allocator); }
+                    Union result(allocator);
+                    auto& intervals = IntervalUnionAccess::intervals(result);
+                    Derived cursor = derived();
+                    cursor.start();
+                    for (Piece<typename Derived::boundary_type> piece; cursor.next(piece); ) {
+                        intervals.push_back(
+                            convert_boundary<Boundary>(piece.start.value), piece.start.closed_as_left(),
+                            convert_boundary<Boundary>(piece.end.value), piece.end.closed_as_right()
+                        );
+                    }
+                    return result;
+                }
+        };
+
+        template<BoundaryConcept Boundary>
+        class LeafExpression: public SetExpression<LeafExpression<Boundary>> {
+            public:
+                using boundary_type = Boundary;
+
+                template<std::size_t InlineCapacity, class Allocator>
+                explicit LeafExpression(const IntervalUnion<Boundary, InlineCapacity, Allocator>& A):
+                    intervals(IntervalUnionAccess::intervals(A).arrays()),
+                    nan(A.isnan())
+                { }
+
+                bool isnan(void) const { return nan; }
+
+                bool contains_infinity(bool positive) const {
+                    if (intervals.size == 0) { return false; }
+                    auto last = intervals.size - 1;
+                    return positive
+                        ? intervals.right_values[last] == boundary_traits<Boundary>::infinity() && intervals.right_closed_at(last)
+                        : contains_negative_infinity(intervals.left_values[0], intervals.left_closed_at(0));
+                }
+
+                void start(void) { i = 0; }
+
+                bool next(Piece<Boundary>& piece) {
+                    if (i == intervals.size) { return false; }
+                    piece.start = Cut<Boundary>::left(intervals.left_values[i], intervals.left_closed_at(i));
+                    piece.end = Cut<Boundary>::right(intervals.right_values[i], intervals.right_closed_at(i));
+                    ++i;
+                    return true;
+                }
+
+            private:
+                IntervalArrays<Boundary> intervals;
+                bool nan;
+                std::size_t i = 0;
+        };
+
+        template<class Operand>
+        class ComplementExpression: public SetExpression<ComplementExpression<Operand>> {
+            // The gaps between the operand's pieces, clipped to the extended real line [-inf,inf] or to
+            // the real line (-inf,inf), which gives the brackets of IntervalUnion::inv. The line of a
+            // type bounded below starts closed either way.
+
+            public:
+                using boundary_type = typename Operand::boundary_type;
+
+                ComplementExpression(Operand operand_in, bool extended_real_line_in):
+                    operand(std::move(operand_in)),
+                    extended_real_line(extended_real_line_in)
+                { }
+
+                bool isnan(void) const { return operand.isnan(); }
+
+                bool contains_infinity(bool positive) const {
+                    return extended_real_line && !operand.contains_infinity(positive);
+                }
+
+                void start(void) {
+                    operand.start();
+                    has_piece = operand.next(piece);
+                    done = false;
+                    cursor = Cut<boundary_type>::left(
+                        boundary_traits<boundary_type>::negative_infinity(),
+                        extended_real_line || boundary_traits<boundary_type>::bounded_below
+                    );
+                    line_end = Cut<boundary_type>::right(boundary_traits<boundary_type>::infinity(), extended_real_line);
+                }
+
+                bool next(Piece<boundary_type>& gap) {
+                    while (!done) {
+                        if (has_piece) {
+                            gap = {cursor, std::min(piece.start, line_end)};
+                            cursor = std::max(cursor, piece.end);
+                            has_piece = operand.next(piece);
+                        } else {
+                            gap = {cursor, line_end};
+                            done = true;
+                        }
+                        if (gap.start < gap.end) { return true; }
+                    }
+                    return false;
+                }
+
+            private:
+                Operand operand;
+                bool extended_real_line;
+                Piece<boundary_type> piece;
+                bool has_piece = false;
+                bool done = true;
+                Cut<boundary_type> cursor{};
+                Cut<boundary_type> line_end{};
+        };
+
+        template<class Lhs, class Rhs>
+        class BinaryExpression {
+            // The state shared by && and ||: both operands' current pieces, converted to the common
+            // boundary type, which is that of the eager operators.
+
+            public:
+                using boundary_type = common_boundary_t<typename Lhs::boundary_type, typename Rhs::boundary_type>;
+
+                BinaryExpression(Lhs lhs_in, Rhs rhs_in):
+                    lhs(std::move(lhs_in)),
+                    rhs(std::move(rhs_in))
+                { }
+
+                bool isnan(void) const { return lhs.isnan() || rhs.isnan(); }
+
+                void start(void) {
+                    lhs.start(); advance_lhs();
+                    rhs.start(); advance_rhs();
+                }
+
+            protected:
+                Lhs lhs;
+                Rhs rhs;
+                Piece<boundary_type> lhs_piece;
+                Piece<boundary_type> rhs_piece;
+                bool has_lhs = false;
+                bool has_rhs = false;
+
+                void advance_lhs(void) {
+                    Piece<typename Lhs::boundary_type> piece;
+                    if ((has_lhs = lhs.next(piece))) {
+                        lhs_piece = {convert_cut<boundary_type>(piece.start), convert_cut<boundary_type>(piece.end)};
+                    }
+                }
+
+                void advance_rhs(void) {
+                    Piece<typename Rhs::boundary_type> piece;
+                    if ((has_rhs = rhs.next(piece))) {
+                        rhs_piece = {convert_cut<boundary_type>(piece.start), convert_cut<boundary_type>(piece.end)};
+                    }
+                }
+        };
+
+        template<class Lhs, class Rhs>
+        class IntersectionExpression: public BinaryExpression<Lhs, Rhs>, public SetExpression<IntersectionExpression<Lhs, Rhs>> {
+            public:
+                using typename BinaryExpression<Lhs, Rhs>::boundary_type;
+                using BinaryExpression<Lhs, Rhs>::BinaryExpression;
+
+                bool contains_infinity(bool positive) const {
+                    return this->lhs.contains_infinity(positive) && this->rhs.contains_infinity(positive);
+                }
+
+                bool next(Piece<boundary_type>& piece) {
+                    // The overlap of the two current pieces, after which whichever ends first is done.
+                    while (this->has_lhs && this->has_rhs) {
+                        piece = {
+                            std::max(this->lhs_piece.start, this->rhs_piece.start),
+                            std::min(this->lhs_piece.end, this->rhs_piece.end)
+                        };
+                        bool lhs_ends_first = this->lhs_piece.end < this->rhs_piece.end;
+                        bool rhs_ends_first = this->rhs_piece.end < this->lhs_piece.end;
+                        if (!rhs_ends_first) { this->advance_lhs(); }
+                        if (!lhs_ends_first) { this->advance_rhs(); }
+                        if (piece.start < piece.end) { return true; }
+                    }
+                    return false;
+                }
+        };
+
+        template<class Lhs, class Rhs>
+        class UnionExpression: public BinaryExpression<Lhs, Rhs>, public SetExpression<UnionExpression<Lhs, Rhs>> {
+            public:
+                using typename BinaryExpression<Lhs, Rhs>::boundary_type;
+                using BinaryExpression<Lhs, Rhs>::BinaryExpression;
+
+                bool contains_infinity(bool positive) const {
+                    return this->lhs.contains_infinity(positive) || this->rhs.contains_infinity(positive);
+                }
+
+                bool next(Piece<boundary_type>& piece) {
+                    // Takes the earlier starting piece and extends it over every piece that overlaps or
+                    // touches it, which in terms of cuts means starting no later than it ends.
+                    if (!take_earlier(piece)) { return false; }
+                    Piece<boundary_type> following;
+                    while (peek_earlier(following) && !(piece.end < following.start)) {
+                        piece.end = std::max(piece.end, following.end);
+                        take_earlier(following);
+                    }
+                    return true;
+                }
+
+            private:
+                bool lhs_earlier(void) const {
+                    return this->has_lhs && (!this->has_rhs || !(this->rhs_piece.start < this->lhs_piece.start));
+                }
+
+                bool peek_earlier(Piece<boundary_type>& piece) const {
+                    if (!this->has_lhs && !this->has_rhs) { return false; }
+                    piece = lhs_earlier() ? this->lhs_piece : this->rhs_piece;
+                    return true;
+                }
+
+                bool take_earlier(Piece<boundary_type>& piece) {
+                    if (!peek_earlier(piece)) { return false; }
+                    if (lhs_earlier()) { this->advance_lhs(); } else { this->advance_rhs(); }
+                    return true;
+                }
+        };
+
+        template<class Derived>
+        auto SetExpression<Derived>::inv(bool extended_real_line) const {
+            return ComplementExpression<Derived>(derived(), extended_real_line);
+        }
+
+        template<class T>
+        concept SetExpressionType = std::derived_from<std::remove_cvref_t<T>, SetExpression<std::remove_cvref_t<T>>>;
+
+        template<class T>
+        concept SetExpressionOperand = SetExpressionType<T> ||
+            requires { typename interval_union_boundary<std::remove_cvref_t<T>>::type; };
+
+        template<class T>
+        auto as_expression(const T& operand) {
+            if constexpr (SetExpressionType<T>) {
+                return operand;
+            } else {
+                return LeafExpression<typename T::boundary_type>(operand);
+            }
+        }
+
+        // The binary operators take an expression on at least one side, and wrap a plain IntervalUnion
+        // on the other. They live here to be found by argument dependent lookup. The difference is the
+        // intersection with the complement in the extended real line, which only differs from the
+        // complement in the real line at the infinities, and so matches operator- whether or not lhs
+        // contains them.
+
+        template<SetExpressionOperand Lhs, SetExpressionOperand Rhs>
+            requires (SetExpressionType<Lhs> || SetExpressionType<Rhs>)
+        auto operator&&(const Lhs& lhs, const Rhs& rhs) {
+            using LhsExpression = decltype(as_expression(lhs));
+            using RhsExpression = decltype(as_expression(rhs));
+            return IntersectionExpression<LhsExpression, RhsExpression>(as_expression(lhs), as_expression(rhs));
+        }
+
+        template<SetExpressionOperand Lhs, SetExpressionOperand Rhs>
+            requires (SetExpressionType<Lhs> || SetExpressionType<Rhs>)
+        auto operator||(const Lhs& lhs, const Rhs& rhs) {
+            using LhsExpression = decltype(as_expression(lhs));
+            using RhsExpression = decltype(as_expression(rhs));
+            return UnionExpression<LhsExpression, RhsExpression>(as_expression(lhs), as_expression(rhs));
+        }
+
+        template<SetExpressionOperand Lhs, SetExpressionOperand Rhs>
+            requires (SetExpressionType<Lhs> || SetExpressionType<Rhs>)
+        auto operator-(const Lhs& lhs, const Rhs& rhs) {
+            return lhs && as_expression(rhs).inv(true);
+        }
+
+    }
+
+    template<BoundaryConcept Boundary, std::size_t InlineCapacity, class Allocator>
+    detail::LeafExpression<Boundary> lazy(const IntervalUnion<Boundary, InlineCapacity, Allocator>& A) {
+        return detail::LeafExpression<Boundary>(A);
+    }
+
+
+}
+
+#endif
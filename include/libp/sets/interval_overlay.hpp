@@ -0,0 +1,111 @@
+#ifndef LIBP_SETS_INTERVAL_OVERLAY_HPP_GUARD
+#define LIBP_SETS_INTERVAL_OVERLAY_HPP_GUARD
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <libp/sets/interval.hpp>
+#include <libp/sets/detail/interval_sweep.hpp>
+
+namespace libp {
+
+    // Overlays of many unions, swept once over all of their boundaries in O(total log k) time for k
+    // unions holding total intervals between them. The overlay splits the line into the segments
+    // over which the set of covering unions is constant, and visits the covered ones in order. A
+    // boundary shared by several unions is told apart by its bracket, so [0,1) and [1,2] meet at 1
+    // without overlapping while [0,1] and [1,2] overlap on the singleton [1,1]. Each function returns
+    // false without visiting anything if any union is NaN.
+
+    namespace detail {
+
+        template<IntervalUnionRange Unions>
+        auto overlay_inputs(Unions&& unions, bool& any_nan) {
+            using Union = std::remove_cvref_t<std::ranges::range_reference_t<Unions>>;
+            std::vector<const typename Union::vector_type*> inputs;
+            any_nan = false;
+            for (const Union& A : unions) {
+                any_nan = any_nan || A.isnan();
+                inputs.push_back(&IntervalUnionAccess::intervals(A));
+            }
+            return inputs;
+        }
+
+        template<class Boundary>
+        Interval<Boundary> segment(const Cut<Boundary>& start, const Cut<Boundary>& end) {
+            return Interval<Boundary>(start.closed_as_left() ? '[' : '(', start.value, end.value, end.closed_as_right() ? ']' : ')');
+        }
+
+    }
+
+    template<IntervalUnionRange Unions, class Visit>
+    bool overlay_counts(Unions&& unions, Visit&& visit) {
+        // Calls visit(segment, count) for each maximal segment covered by the same number count != 0 of
+        // the unions.
+        using Boundary = detail::interval_union_boundary_t<std::ranges::range_reference_t<Unions>>;
+        bool any_nan;
+        auto inputs = detail::overlay_inputs(unions, any_nan);
+        if (any_nan) { return false; }
+        std::size_t covering = 0;
+        detail::Cut<Boundary> start{};
+        detail::sweep_cuts<Boundary>(inputs, [&](const detail::Cut<Boundary>& cut, const auto& changes) {
+            std::size_t was_covering = covering;
+            for (const auto& change : changes) {
+                if (change.second) { ++covering; } else { --covering; }
+            }
+            if (covering != was_covering) {
+                if (was_covering != 0) { visit(detail::segment(start, cut), was_covering); }
+                start = cut;
+            }
+        });
+        return true;
+    }
+
+    template<IntervalUnionRange Unions, class Visit>
+    bool overlay_members(Unions&& unions, Visit&& visit) {
+        // Calls visit(segment, members) for each maximal segment covered by at least one union, where
+        // bit k%64 of members[k/64] is set when the k-th union covers the segment. Every boundary
+        // changes the members, so these segments are the elementary pieces of the overlay.
+        using Boundary = detail::interval_union_boundary_t<std::ranges::range_reference_t<Unions>>;
+        bool any_nan;
+        auto inputs = detail::overlay_inputs(unions, any_nan);
+        if (any_nan) { return false; }
+        std::vector<std::uint64_t> members((inputs.size() + 63)/64);
+        std::size_t covering = 0;
+        detail::Cut<Boundary> start{};
+        detail::sweep_cuts<Boundary>(inputs, [&](const detail::Cut<Boundary>& cut, const auto& changes) {
+            if (covering != 0) { visit(detail::segment(start, cut), std::span<const std::uint64_t>(members)); }
+            for (const auto& change : changes) {
+                members[change.first / 64] ^= std::uint64_t(1) << (change.first % 64);
+                if (change.second) { ++covering; } else { --covering; }
+            }
+            start = cut;
+        });
+        return true;
+    }
+
+    template<IntervalUnionRange Unions>
+    auto at_least_k(Unions&& unions, std::size_t k) {
+        // The points covered by at least k of the unions, or NaN if any union is NaN. Every point of the
+        // extended real line is covered by at least none of them.
+        using Union = std::remove_cvref_t<std::ranges::range_reference_t<Unions>>;
+        using Boundary = typename Union::boundary_type;
+        bool any_nan;
+        auto inputs = detail::overlay_inputs(unions, any_nan);
+        auto allocator = inputs.empty() ? typename Union::allocator_type() : inputs.front()->get_allocator();
+        if (any_nan) { return Union::nan(allocator); }
+        if (k == 0) { return Union::universal(true, allocator); }
+        Union covered(allocator);
+        if (k <= inputs.size()) {
+            auto& intervals = detail::IntervalUnionAccess::intervals(covered);
+            detail::covered_by_at_least<Boundary>(inputs, k, [&](const auto& l, bool lc, const auto& r, bool rc) {
+                intervals.push_back(l, lc, r, rc);
+            });
+        }
+        return covered;
+    }
+
+}
+
+#endif
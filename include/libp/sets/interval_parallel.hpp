@@ -0,0 +1,343 @@
+#ifndef LIBP_SETS_INTERVAL_PARALLEL_HPP_GUARD
+#define LIBP_SETS_INTERVAL_PARALLEL_HPP_GUARD
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <libp/sets/interval.hpp>
+#include <libp/sets/detail/interval_merge.hpp>
+#include <libp/sets/detail/parallel.hpp>
+
+namespace libp {
+
+    // Multi-threaded counterparts of &&, || and inv and of construction from unsorted intervals,
+    // for very large unions, returning exactly what their serial counterparts return. The binary
+    // operations cut the line at the left boundaries of evenly spaced intervals of the larger
+    // operand, find each operand's intervals within every window between consecutive cuts by binary
+    // search, and merge the windows on separate threads, clipping any interval that straddles a
+    // cut. A piece of the result that straddles a cut comes out as two pieces meeting at it, which
+    // are joined again when the windows are stitched together.
+
+    struct ParallelOptions {
+        // The number of threads to use, or 0 for one per hardware thread.
+        unsigned threads = 0;
+
+        // The fewest intervals worth giving a thread of their own. Inputs with fewer intervals than this
+        // between them are handled serially.
+        std::size_t serial_threshold = std::size_t(1) << 16;
+    };
+
+    namespace detail {
+
+        inline std::size_t parallel_tasks(std::size_t size, std::size_t splittable, const ParallelOptions& options) {
+            // The number of threads to share size intervals between, splitting a sequence of splittable.
+            auto tasks = std::min(thread_count(options.threads), size / std::max<std::size_t>(options.serial_threshold, 1));
+            return std::min(tasks, splittable);
+        }
+
+        template<class Boundary>
+        struct Window {
+            // The cuts bounding one partition of the line, where a missing cut leaves that side unbounded.
+            Cut<Boundary> lower;
+            Cut<Boundary> upper;
+            bool has_lower;
+            bool has_upper;
+        };
+
+        template<class Intervals, class Boundary>
+        class WindowIntervals {
+            // The intervals of a canonical sequence that meet a window, clipped to it.
+
+            public:
+                WindowIntervals(const Intervals& intervals_in, const Window<Boundary>& window_in):
+                    intervals(intervals_in),
+                    window(window_in)
+                {
+                    auto first_not = [&](auto&& pred) {
+                        std::size_t lo = 0, hi = intervals.size();
+                        while (lo != hi) {
+                            std::size_t mid = lo + (hi - lo)/2;
+                            if (pred(mid)) { lo = mid + 1; } else { hi = mid; }
+                        }
+                        return lo;
+                    };
+                    offset = !window.has_lower ? 0 : first_not([&](std::size_t i) {
+                        return !(window.lower < right_cut(i));
+                    });
+                    std::size_t end = !window.has_upper ? intervals.size() : first_not([&](std::size_t i) {
+                        return left_cut(i) < window.upper;
+                    });
+                    count = end - offset;
+                }
+
+                std::size_t size(void) const { return count; }
+
+                Boundary left_value(std::size_t i) const {
+                    return clips_left(i) ? window.lower.value : Boundary(intervals.left_value(offset + i));
+                }
+
+                bool left_closed(std::size_t i) const {
+                    return clips_left(i) ? window.lower.closed_as_left() : intervals.left_closed(offset + i);
+                }
+
+                Boundary right_value(std::size_t i) const {
+                    return clips_right(i) ? window.upper.value : Boundary(intervals.right_value(offset + i));
+                }
+
+                bool right_closed(std::size_t i) const {
+                    return clips_right(i) ? window.upper.closed_as_right() : intervals.right_closed(offset + i);
+                }
+
+            private:
+                const Intervals& intervals;
+                Window<Boundary> window;
+                std::size_t offset;
+                std::size_t count;
+
+                Cut<Boundary> left_cut(std::size_t i) const {
+                    return Cut<Boundary>::left(intervals.left_value(i), intervals.left_closed(i));
+                }
+
+                Cut<Boundary> right_cut(std::size_t i) const {
+                    return Cut<Boundary>::right(intervals.right_value(i), intervals.right_closed(i));
+                }
+
+                bool clips_left(std::size_t i) const {
+                    return i == 0 && window.has_lower && left_cut(offset) < window.lower;
+                }
+
+                bool clips_right(std::size_t i) const {
+                    return i + 1 == count && window.has_upper && window.upper < right_cut(offset + i);
+                }
+        };
+
+        template<class Intervals, class Scratch>
+        void stitch_windows(Intervals& intervals, const std::vector<Scratch>& windows) {
+            // Concatenates the canonical results of consecutive windows onto intervals. The leading
+            // pieces of a window that meet the last interval so far are joined to it.
+            std::size_t total = intervals.size();
+            for (const auto& window : windows) { total += window.size(); }
+            intervals.reserve(total);
+            for (const auto& window : windows) {
+                std::size_t i = 0;
+                for (; i != window.size() && !intervals.empty(); ++i) {
+                    auto last = intervals.size() - 1;
+                    if (!touches(intervals.right_value(last), intervals.right_closed(last), window.left_value(i), window.left_closed(i))) { break; }
+                    if (precedes_right(intervals.right_value(last), intervals.right_closed(last), window.right_value(i), window.right_closed(i))) {
+                        intervals.set_right(last, window.right_value(i), window.right_closed(i));
+                    }
+                }
+                for (; i != window.size(); ++i) {
+                    intervals.push_back(window.left_value(i), window.left_closed(i), window.right_value(i), window.right_closed(i));
+                }
+            }
+        }
+
+        template<class Boundary, class Scratch>
+        void coalesce_pieces(std::vector<std::pair<Cut<Boundary>, Cut<Boundary>>>& pieces, Scratch& out) {
+            // Sorts unempty pieces, each given by its left and right cut, and appends their canonical
+            // union to out.
+            std::sort(pieces.begin(), pieces.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+            out.reserve(out.size() + pieces.size());
+            for (const auto& [left, right] : pieces) {
+                if (!out.empty()) {
+                    auto last = out.size() - 1;
+                    auto last_right = Cut<Boundary>::right(out.right_value(last), out.right_closed(last));
+                    if (!(last_right < left)) {
+                        if (last_right < right) { out.set_right(last, right.value, right.closed_as_right()); }
+                        continue;
+                    }
+                }
+                out.push_back(left.value, left.closed_as_left(), right.value, right.closed_as_right());
+            }
+        }
+
+        template<class Union, class Lhs, class Rhs, class Merge>
+        Union parallel_merge(Union result, const Lhs& lhs, const Rhs& rhs, std::size_t tasks, Merge&& merge) {
+            // Runs merge(lhs_window, rhs_window, out) for tasks windows at once, each into scratch
+            // storage, and then concatenates the scratch results into result, joining pieces that meet
+            // at a cut. The cuts are the left boundaries of intervals of the larger operand, which has at
+            // least tasks intervals, so they are distinct and every window is unempty.
+            using Boundary = typename Union::boundary_type;
+            using Scratch = IntervalVector<Boundary, 0, std::allocator<Boundary>>;
+            auto pivot = [&](std::size_t t) {
+                auto pick = [&](const auto& intervals) {
+                    auto i = t*intervals.size()/tasks;
+                    return Cut<Boundary>::left(intervals.left_value(i), intervals.left_closed(i));
+                };
+                return lhs.size() >= rhs.size() ? pick(lhs) : pick(rhs);
+            };
+
+            std::vector<Scratch> scratch(tasks);
+            parallel_for(tasks, [&](std::size_t t) {
+                Window<Boundary> window{{}, {}, t != 0, t + 1 != tasks};
+                if (window.has_lower) { window.lower = pivot(t); }
+                if (window.has_upper) { window.upper = pivot(t + 1); }
+                WindowIntervals<Lhs, Boundary> lhs_window(lhs, window);
+                WindowIntervals<Rhs, Boundary> rhs_window(rhs, window);
+                auto& out = scratch[t];
+                out.reserve(lhs_window.size() + rhs_window.size());
+                merge(lhs_window, rhs_window, out);
+            });
+
+            stitch_windows(IntervalUnionAccess::intervals(result), scratch);
+            return result;
+        }
+
+    }
+
+    template<BoundaryConcept LhsBoundary, std::size_t LhsCapacity, class LhsAllocator, BoundaryConcept RhsBoundary, std::size_t RhsCapacity, class RhsAllocator>
+    auto parallel_intersection(
+        const IntervalUnion<LhsBoundary, LhsCapacity, LhsAllocator>& lhs,
+        const IntervalUnion<RhsBoundary, RhsCapacity, RhsAllocator>& rhs,
+        const ParallelOptions& options = {}
+    ) {
+        // lhs && rhs.
+        using CommonIntervalUnion = detail::common_interval_union_t<IntervalUnion<LhsBoundary, LhsCapacity, LhsAllocator>, RhsBoundary>;
+        using Access = detail::IntervalUnionAccess;
+        const auto& a = Access::intervals(lhs);
+        const auto& b = Access::intervals(rhs);
+        auto tasks = detail::parallel_tasks(a.size() + b.size(), std::max(a.size(), b.size()), options);
+        if (tasks <= 1 || lhs.isnan() || rhs.isnan() || lhs.isempty() || rhs.isempty()) { return lhs && rhs; }
+        typename CommonIntervalUnion::allocator_type allocator(lhs.get_allocator());
+        return detail::parallel_merge(CommonIntervalUnion(allocator), a, b, tasks, [](const auto& x, const auto& y, auto& out) {
+            detail::intersect_sorted(x, y, [&](const auto& l, bool lc, const auto& r, bool rc) {
+                out.push_back(l, lc, r, rc);
+            });
+        });
+    }
+
+    template<BoundaryConcept LhsBoundary, std::size_t LhsCapacity, class LhsAllocator, BoundaryConcept RhsBoundary, std::size_t RhsCapacity, class RhsAllocator>
+    auto parallel_union(
+        const IntervalUnion<LhsBoundary, LhsCapacity, LhsAllocator>& lhs,
+        const IntervalUnion<RhsBoundary, RhsCapacity, RhsAllocator>& rhs,
+        const ParallelOptions& options = {}
+    ) {
+        // lhs || rhs.
+        using CommonIntervalUnion = detail::common_interval_union_t<IntervalUnion<LhsBoundary, LhsCapacity, LhsAllocator>, RhsBoundary>;
+        using Access = detail::IntervalUnionAccess;
+        const auto& a = Access::intervals(lhs);
+        const auto& b = Access::intervals(rhs);
+        auto tasks = detail::parallel_tasks(a.size() + b.size(), std::max(a.size(), b.size()), options);
+        if (tasks <= 1 || lhs.isnan() || rhs.isnan()) { return lhs || rhs; }
+        typename CommonIntervalUnion::allocator_type allocator(lhs.get_allocator());
+        return detail::parallel_merge(CommonIntervalUnion(allocator), a, b, tasks, [](const auto& x, const auto& y, auto& out) {
+            detail::merge_sorted(x, y, [&](const auto& l, bool lc, const auto& r, bool rc) {
+                if (!out.empty()) {
+                    auto last = out.size() - 1;
+                    if (detail::touches(out.right_value(last), out.right_closed(last), l, lc)) {
+                        if (detail::precedes_right(out.right_value(last), out.right_closed(last), r, rc)) {
+                            out.set_right(last, r, rc);
+                        }
+                        return;
+                    }
+                }
+                out.push_back(l, lc, r, rc);
+            });
+        });
+    }
+
+    template<BoundaryConcept Boundary, std::size_t InlineCapacity, class Allocator>
+    IntervalUnion<Boundary, InlineCapacity, Allocator> parallel_inv(
+        const IntervalUnion<Boundary, InlineCapacity, Allocator>& A,
+        bool extended_real_line = false,
+        const ParallelOptions& options = {}
+    ) {
+        // A.inv(extended_real_line). Gap j of the complement depends only on intervals j-1 and j, so the
+        // threads write disjoint ranges of the result directly, in multiples of 64 intervals so that no
+        // two of them share a word of brackets.
+        using Access = detail::IntervalUnionAccess;
+        const auto& a = Access::intervals(A);
+        auto tasks = detail::parallel_tasks(a.size(), a.size(), options);
+        if (tasks <= 1 || A.isnan()) { return A.inv(extended_real_line); }
+        detail::ComplementIntervals<typename IntervalUnion<Boundary, InlineCapacity, Allocator>::vector_type, Boundary> complement(a, extended_real_line);
+        IntervalUnion<Boundary, InlineCapacity, Allocator> ret(A.get_allocator());
+        auto& intervals = Access::intervals(ret);
+        std::size_t n = complement.size();
+        intervals.resize_for_overwrite(n);
+        std::size_t chunk = (n/tasks + 63)/64*64;
+        detail::parallel_for(tasks, [&](std::size_t t) {
+            std::size_t first = std::min(n, t*chunk);
+            std::size_t last = t + 1 == tasks ? n : std::min(n, (t + 1)*chunk);
+            for (std::size_t j = first; j != last; ++j) {
+                intervals.set_left(j, complement.left_value(j), complement.left_closed(j));
+                intervals.set_right(j, complement.right_value(j), complement.right_closed(j));
+            }
+        });
+        return ret;
+    }
+
+    template<std::random_access_iterator Iter, class Allocator = std::allocator<typename std::iter_value_t<Iter>::boundary_type>>
+    auto parallel_interval_union(Iter first, Iter last, const ParallelOptions& options = {}, const Allocator& allocator = Allocator()) {
+        // IntervalUnion(first, last, allocator), including the NaN union when any interval is NaN. Each
+        // thread sorts and canonicalises a chunk of the input. The line is then cut at left boundaries
+        // sampled evenly from every chunk, and each thread merges the pieces of all the chunks within
+        // one window between cuts, as the binary operations do.
+        using Boundary = typename std::iter_value_t<Iter>::boundary_type;
+        using Union = IntervalUnion<Boundary, 2, Allocator>;
+        using Scratch = IntervalVector<Boundary, 0, std::allocator<Boundary>>;
+        using Cut = detail::Cut<Boundary>;
+        std::size_t n = last - first;
+        auto tasks = detail::parallel_tasks(n, n, options);
+        if (tasks <= 1) { return Union(first, last, allocator); }
+
+        std::vector<Scratch> chunks(tasks);
+        std::vector<std::size_t> first_nan(tasks, n);
+        detail::parallel_for(tasks, [&](std::size_t t) {
+            std::vector<std::pair<Cut, Cut>> pieces; pieces.reserve((t + 1)*n/tasks - t*n/tasks);
+            for (std::size_t i = t*n/tasks; i != (t + 1)*n/tasks; ++i) {
+                const Interval<Boundary>& I = first[i];
+                if (I.isnan()) {
+                    first_nan[t] = i;
+                    return;
+                } else if (!I.isempty()) {
+                    pieces.emplace_back(Cut::left(I.left_value(), I.left_bracket() == '['), Cut::right(I.right_value(), I.right_bracket() == ']'));
+                }
+            }
+            detail::coalesce_pieces(pieces, chunks[t]);
+        });
+        if (auto i = *std::min_element(first_nan.begin(), first_nan.end()); i != n) {
+            return Union(Interval<Boundary>(first[i]), allocator);
+        }
+
+        std::vector<Cut> samples;
+        for (const auto& chunk : chunks) {
+            for (std::size_t t = 1; t != tasks && !chunk.empty(); ++t) {
+                auto i = t*chunk.size()/tasks;
+                samples.push_back(Cut::left(chunk.left_value(i), chunk.left_closed(i)));
+            }
+        }
+        std::sort(samples.begin(), samples.end());
+        std::vector<Cut> cuts;
+        for (std::size_t t = 1; t != tasks && !samples.empty(); ++t) {
+            const auto& cut = samples[t*samples.size()/tasks];
+            if (cuts.empty() || cuts.back() < cut) { cuts.push_back(cut); }
+        }
+
+        std::vector<Scratch> windows(cuts.size() + 1);
+        detail::parallel_for(windows.size(), [&](std::size_t w) {
+            detail::Window<Boundary> window{{}, {}, w != 0, w != cuts.size()};
+            if (window.has_lower) { window.lower = cuts[w - 1]; }
+            if (window.has_upper) { window.upper = cuts[w]; }
+            std::vector<std::pair<Cut, Cut>> pieces;
+            for (const auto& chunk : chunks) {
+                detail::WindowIntervals<Scratch, Boundary> clipped(chunk, window);
+                for (std::size_t i = 0; i != clipped.size(); ++i) {
+                    pieces.emplace_back(Cut::left(clipped.left_value(i), clipped.left_closed(i)), Cut::right(clipped.right_value(i), clipped.right_closed(i)));
+                }
+            }
+            detail::coalesce_pieces(pieces, windows[w]);
+        });
+
+        Union result(allocator);
+        detail::stitch_windows(detail::IntervalUnionAccess::intervals(result), windows);
+        return result;
+    }
+
+}
+
+#endif
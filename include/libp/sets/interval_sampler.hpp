@@ -0,0 +1,162 @@
+#ifndef LIBP_SETS_INTERVAL_SAMPLER_HPP_GUARD
+#define LIBP_SETS_INTERVAL_SAMPLER_HPP_GUARD
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <libp/sets/interval.hpp>
+
+namespace libp {
+
+    template<std::floating_point Boundary>
+    class UniformSampler {
+        // Draws from the uniform distribution on an IntervalUnion: picks an interval with probability
+        // proportional to its length from an alias table, in constant time whatever the number of
+        // intervals, then a point uniformly inside it. The lengths are computed once, when the sampler
+        // is built, and the sampler keeps its own copy of the intervals.
+        //
+        // Intervals of zero length have no weight unless every interval has zero length, in which case
+        // the union is a finite set of points and each is drawn with equal probability. A union that is
+        // NaN or empty, or has an unbounded interval, has no uniform distribution, and every draw is
+        // NaN; measure() tells these cases apart. A bounded union is sampled even when its length
+        // overflows Boundary, as only the ratios of the lengths are used.
+
+        public:
+            using result_type = Boundary;
+
+            template<std::size_t InlineCapacity, class Allocator>
+            explicit UniformSampler(const IntervalUnion<Boundary, InlineCapacity, Allocator>& A) {
+                if (A.isnan()) { measure_m = boundary_traits<Boundary>::nan(); return; }
+                const auto& intervals = detail::IntervalUnionAccess::intervals(A);
+                const std::size_t n = intervals.size();
+                measure_m = 0;
+                for (std::size_t i = 0; i != n; ++i) { measure_m += intervals.right_value(i) - intervals.left_value(i); }
+                if (n == 0 || std::isinf(intervals.left_value(0)) || std::isinf(intervals.right_value(n - 1))) { return; }
+                bool points = measure_m == 0;
+                std::vector<Boundary> left_values, right_values;
+                std::vector<unsigned char> open;
+                for (std::size_t i = 0; i != n; ++i) {
+                    const Boundary& l = intervals.left_value(i);
+                    const Boundary& r = intervals.right_value(i);
+                    bool left_open = !intervals.left_closed(i);
+                    bool right_open = !intervals.right_closed(i);
+                    // An open interval one ulp wide holds no value of the boundary type to draw.
+                    if ((points || l != r) && !(left_open && right_open && std::nextafter(l, r) == r)) {
+                        left_values.push_back(l);
+                        right_values.push_back(r);
+                        open.push_back(left_open | (right_open << 1));
+                    }
+                }
+                if (!left_values.empty()) { build_alias_table(left_values, right_values, open, points); }
+            }
+
+            // The total length of the intervals: zero for an empty union or one of points only, infinite
+            // when an interval is unbounded or the total overflows, and NaN for a NaN union.
+            Boundary measure(void) const { return measure_m; }
+
+            template<std::uniform_random_bit_generator URBG>
+            Boundary operator()(URBG& g) const {
+                if (columns.empty()) { return boundary_traits<Boundary>::nan(); }
+                std::uniform_real_distribution<Boundary> unit_dist(0, 1);
+                const Boundary n = Boundary(columns.size());
+                while (true) {
+                    // One uniform picks both the column, by its integer part, and the coin, by the rest.
+                    Boundary u = unit_dist(g)*n;
+                    std::size_t i = std::min(std::size_t(u), columns.size() - 1);
+                    const Column& column = columns[i];
+                    std::size_t k = u - Boundary(i) >= column.probability;
+                    // An open end, or a point past the right end, is reached only when rounding lands on
+                    // it, and then the point is drawn again rather than moved, which would weight it.
+                    const Boundary& l = column.left_values[k];
+                    const Boundary& r = column.right_values[k];
+                    // std::lerp, unlike l + u*(r - l), does not overflow when r - l does.
+                    Boundary x = std::lerp(l, r, unit_dist(g));
+                    if ((l < x || !(column.open[k] & 1)) && (x < r || (x == r && !(column.open[k] & 2)))) {
+                        return x;
+                    }
+                }
+            }
+
+            template<std::uniform_random_bit_generator URBG>
+            void operator()(URBG& g, std::span<Boundary> out) const {
+                // Fills out with independent draws, the same as calling operator() once for each element.
+                for (auto& x : out) { x = (*this)(g); }
+            }
+
+        private:
+            struct Column {
+                // A column of the alias table, holding both intervals it can pick so that a draw reads
+                // one column and nothing else: its own interval, taken with the given probability, and
+                // its alias. Bit 0 of open marks an open left end and bit 1 an open right end.
+                Boundary probability;
+                Boundary left_values[2];
+                Boundary right_values[2];
+                unsigned char open[2];
+            };
+
+            std::vector<Column> columns;
+            Boundary measure_m = 0;
+
+            void build_alias_table(
+                const std::vector<Boundary>& left_values,
+                const std::vector<Boundary>& right_values,
+                const std::vector<unsigned char>& open,
+                bool points
+            ) {
+                // Vose's method: columns of average weight are filled with one small weight topped up by
+                // part of a large one, so each draw needs one column and one coin. The weights are the
+                // lengths relative to the largest, halved first if any of them overflows, so that
+                // neither they nor their total can overflow.
+                const std::size_t n = left_values.size();
+                std::vector<Boundary> scaled(n);
+                std::vector<std::size_t> aliases(n);
+                std::vector<std::size_t> small, large;
+                Boundary largest = 0;
+                for (std::size_t i = 0; i != n; ++i) {
+                    scaled[i] = points ? Boundary(1) : right_values[i] - left_values[i];
+                    largest = std::max(largest, scaled[i]);
+                }
+                if (std::isinf(largest)) {
+                    largest = 0;
+                    for (std::size_t i = 0; i != n; ++i) {
+                        scaled[i] = right_values[i]/2 - left_values[i]/2;
+                        largest = std::max(largest, scaled[i]);
+                    }
+                }
+                Boundary total = 0;
+                for (std::size_t i = 0; i != n; ++i) { total += scaled[i] /= largest; }
+                for (std::size_t i = 0; i != n; ++i) {
+                    scaled[i] *= Boundary(n)/total;
+                    (scaled[i] < 1 ? small : large).push_back(i);
+                }
+                columns.resize(n);
+                while (!small.empty() && !large.empty()) {
+                    std::size_t s = small.back(); small.pop_back();
+                    std::size_t l = large.back();
+                    columns[s].probability = scaled[s];
+                    aliases[s] = l;
+                    scaled[l] -= 1 - scaled[s];
+                    if (scaled[l] < 1) { large.pop_back(); small.push_back(l); }
+                }
+                // What is left over is within rounding of a full column.
+                for (auto i : small) { columns[i].probability = 1; aliases[i] = i; }
+                for (auto i : large) { columns[i].probability = 1; aliases[i] = i; }
+                for (std::size_t i = 0; i != n; ++i) {
+                    for (std::size_t k = 0; k != 2; ++k) {
+                        std::size_t j = k == 0 ? i : aliases[i];
+                        columns[i].left_values[k] = left_values[j];
+                        columns[i].right_values[k] = right_values[j];
+                        columns[i].open[k] = open[j];
+                    }
+                }
+            }
+    };
+
+}
+
+#endif
@@ -0,0 +1,198 @@
+#ifndef LIBP_SETS_INTERVAL_SET_HPP_GUARD
+#define LIBP_SETS_INTERVAL_SET_HPP_GUARD
+
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <utility>
+
+#include <libp/sets/interval.hpp>
+
+namespace libp {
+
+    template<BoundaryConcept Boundary, class Allocator = std::allocator<Boundary>>
+    class IntervalSet {
+        // A union of intervals that changes one interval at a time. IntervalUnion stores its intervals
+        // contiguously, so adding or removing one rewrites everything after it; here each interval is
+        // a node of an ordered tree keyed by its left boundary, and insert and erase only touch the
+        // intervals they merge with or cut, in O(log n) plus the number of those. The set stays
+        // canonical after every change, coalescing intervals exactly as IntervalUnion does, so the
+        // two convert into each other in O(n) without sorting.
+        //
+        // Boundaries are held as cuts (see detail::Cut), so that an interval is the pair of cuts
+        // around it and every bracket comparison is a single one. Like IntervalUnion, the set is NaN
+        // once a NaN interval has been inserted or erased, until it is cleared.
+
+        using Cut = detail::Cut<Boundary>;
+        using map_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<std::pair<const Cut, Cut>>;
+        using map_type = std::map<Cut, Cut, std::less<Cut>, map_allocator>;
+
+        public:
+            using boundary_type = Boundary;
+            using value_type = Interval<Boundary>;
+            using size_type = std::size_t;
+            using allocator_type = Allocator;
+
+            class const_iterator {
+                // A bidirectional iterator whose reference type is an Interval prvalue assembled from
+                // the two cuts of a node.
+
+                public:
+                    using value_type = Interval<Boundary>;
+                    using reference = value_type;
+                    using difference_type = std::ptrdiff_t;
+                    using iterator_category = std::input_iterator_tag;
+                    using iterator_concept = std::bidirectional_iterator_tag;
+
+                    struct pointer {
+                        value_type interval;
+                        const value_type* operator->(void) const { return &interval; }
+                    };
+
+                    const_iterator() = default;
+
+                    explicit const_iterator(typename map_type::const_iterator iter_in): iter(iter_in) { }
+
+                    reference operator*(void) const {
+                        return value_type(
+                            iter->first.closed_as_left() ? '[' : '(',
+                            iter->first.value,
+                            iter->second.value,
+                            iter->second.closed_as_right() ? ']' : ')'
+                        );
+                    }
+
+                    pointer operator->(void) const { return {**this}; }
+
+                    const_iterator& operator++(void) { ++iter; return *this; }
+                    const_iterator operator++(int) { auto ret = *this; ++iter; return ret; }
+                    const_iterator& operator--(void) { --iter; return *this; }
+                    const_iterator operator--(int) { auto ret = *this; --iter; return ret; }
+
+                    bool operator==(const const_iterator& rhs) const { return iter == rhs.iter; }
+
+                private:
+                    typename map_type::const_iterator iter;
+            };
+
+            IntervalSet(): IntervalSet(Allocator()) { }
+
+            explicit IntervalSet(const Allocator& allocator): cuts(map_allocator(allocator)) { }
+
+            IntervalSet(std::initializer_list<Interval<Boundary>> l, const Allocator& allocator = Allocator()):
+                IntervalSet(allocator)
+            {
+                for (const auto& I : l) { insert(I); }
+            }
+
+            template<std::size_t InlineCapacity, class UnionAllocator>
+            explicit IntervalSet(const IntervalUnion<Boundary, InlineCapacity, UnionAllocator>& A, const Allocator& allocator = Allocator()):
+                IntervalSet(allocator)
+            {
+                if (A.isnan()) { nan_m = true; return; }
+                const auto& intervals = detail::IntervalUnionAccess::intervals(A);
+                for (std::size_t i = 0; i != intervals.size(); ++i) {
+                    cuts.emplace_hint(
+                        cuts.cend(),
+                        Cut::left(intervals.left_value(i), intervals.left_closed(i)),
+                        Cut::right(intervals.right_value(i), intervals.right_closed(i))
+                    );
+                }
+            }
+
+            explicit operator IntervalUnion<Boundary>() const {
+                if (nan_m) { return IntervalUnion<Boundary>::nan(); }
+                IntervalUnion<Boundary> A;
+                auto& intervals = detail::IntervalUnionAccess::intervals(A);
+                intervals.reserve(cuts.size());
+                for (const auto& [left, right] : cuts) {
+                    intervals.push_back(left.value, left.closed_as_left(), right.value, right.closed_as_right());
+                }
+                return A;
+            }
+
+            allocator_type get_allocator(void) const { return allocator_type(cuts.get_allocator()); }
+
+            size_type size(void) const { return cuts.size(); }
+
+            const_iterator cbegin(void) const { return const_iterator(cuts.cbegin()); }
+            const_iterator cend(void) const { return const_iterator(cuts.cend()); }
+
+            bool isempty(void) const { return cuts.empty() && !nan_m; }
+
+            bool isnan(void) const { return nan_m; }
+
+            void clear(void) { cuts.clear(); nan_m = false; }
+
+            template<BoundaryConcept IntBoundary>
+            void insert(const Interval<IntBoundary>& interval) {
+                // Adds the interval, merging it with every interval it overlaps or touches.
+                const Interval<Boundary> I = interval;
+                if (I.isnan()) { set_to_nan(); return; }
+                if (nan_m || I.isempty()) { return; }
+                Cut left = Cut::left(I.left_value(), I.left_bracket() == '[');
+                Cut right = Cut::right(I.right_value(), I.right_bracket() == ']');
+                // The first interval that could touch I is the last starting at or before it, if that
+                // one reaches it, and otherwise the first starting after it. Intervals touch when one's
+                // right cut is no earlier than the other's left cut.
+                auto iter = cuts.upper_bound(left);
+                if (iter != cuts.begin() && !(std::prev(iter)->second < left)) { --iter; }
+                while (iter != cuts.end() && !(right < iter->first)) {
+                    if (iter->first < left) { left = iter->first; }
+                    if (right < iter->second) { right = iter->second; }
+                    iter = cuts.erase(iter);
+                }
+                cuts.emplace_hint(iter, left, right);
+            }
+
+            template<BoundaryConcept IntBoundary>
+            void erase(const Interval<IntBoundary>& interval) {
+                // Removes the interval, trimming or splitting every interval it overlaps.
+                const Interval<Boundary> I = interval;
+                if (I.isnan()) { set_to_nan(); return; }
+                if (nan_m || I.isempty()) { return; }
+                Cut left = Cut::left(I.left_value(), I.left_bracket() == '[');
+                Cut right = Cut::right(I.right_value(), I.right_bracket() == ']');
+                auto iter = cuts.upper_bound(left);
+                if (iter != cuts.begin() && left < std::prev(iter)->second) { --iter; }
+                while (iter != cuts.end() && iter->first < right) {
+                    auto [a, b] = *iter;
+                    iter = cuts.erase(iter);
+                    if (a < left) { cuts.emplace_hint(iter, a, left); }
+                    if (right < b) { iter = cuts.emplace_hint(iter, right, b); break; }
+                }
+            }
+
+            template<BoundaryConcept S, BoundaryConcept T>
+            void insert(char left_bracket_in, S left_value_in, T right_value_in, char right_bracket_in) {
+                insert(Interval<Boundary>(left_bracket_in, std::move(left_value_in), std::move(right_value_in), right_bracket_in));
+            }
+
+            template<BoundaryConcept S, BoundaryConcept T>
+            void erase(char left_bracket_in, S left_value_in, T right_value_in, char right_bracket_in) {
+                erase(Interval<Boundary>(left_bracket_in, std::move(left_value_in), std::move(right_value_in), right_bracket_in));
+            }
+
+            template<BoundaryConcept BoundaryX>
+            Boundary operator()(const BoundaryX& x) const {
+                // x is in the last interval starting at or before it, if that one reaches past it.
+                if (nan_m) { return false; }
+                auto iter = cuts.upper_bound(Cut{Boundary(x), false});
+                return iter != cuts.begin() && !(std::prev(iter)->second < Cut{Boundary(x), true});
+            }
+
+            bool operator==(const IntervalSet& rhs) const { return !nan_m && !rhs.nan_m && cuts == rhs.cuts; }
+            bool operator!=(const IntervalSet& rhs) const { return !nan_m && !rhs.nan_m && cuts != rhs.cuts; }
+
+        private:
+            map_type cuts;
+            bool nan_m = false;
+
+            void set_to_nan(void) { cuts.clear(); nan_m = true; }
+    };
+
+}
+
+#endif
@@ -0,0 +1,284 @@
+#ifndef LIBP_SETS_INTERVAL_STATIC_HPP_GUARD
+#define LIBP_SETS_INTERVAL_STATIC_HPP_GUARD
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <new>
+
+#include <libp/sets/interval.hpp>
+
+namespace libp {
+
+    enum class CapacityPolicy {
+        // What a StaticIntervalUnion does with a result of more intervals than it can hold. Under error
+        // the result is NaN, which every later operation propagates. Under saturate the intervals past
+        // the last that fits are merged into it, so the result holds the exact one and the gaps lost.
+        error,
+        saturate
+    };
+
+    namespace detail {
+
+        template<class T>
+        struct InlineOnlyAllocator {
+            // The allocator of a vector that never outgrows its inline storage, so is never asked for
+            // memory. Should it be, it fails rather than reach for the heap.
+            using value_type = T;
+
+            constexpr InlineOnlyAllocator() = default;
+
+            template<class U>
+            constexpr InlineOnlyAllocator(const InlineOnlyAllocator<U>&) noexcept { }
+
+            T* allocate(std::size_t) { throw std::bad_alloc(); }
+
+            constexpr void deallocate(T*, std::size_t) noexcept { }
+
+            friend constexpr bool operator==(const InlineOnlyAllocator&, const InlineOnlyAllocator&) { return true; }
+        };
+
+    }
+
+    template<BoundaryConcept Boundary, std::size_t N, CapacityPolicy Policy = CapacityPolicy::error>
+    class StaticIntervalUnion {
+        // A union of at most N intervals held inside the object, for code that may not allocate. The
+        // set operations are those of IntervalUnion, between unions of the same type, and write their
+        // results straight into inline storage; a result that needs more than N intervals is handled
+        // as Policy directs, and marks it, and every union computed from it, as overflowed.
+
+        static_assert(N != 0, "a StaticIntervalUnion must hold at least one interval, if only to be NaN");
+
+        using vector_type = IntervalVector<Boundary, N, detail::InlineOnlyAllocator<Boundary>>;
+
+        public:
+            using boundary_type = Boundary;
+            using value_type = Interval<Boundary>;
+            using size_type = std::size_t;
+            using const_iterator = typename vector_type::const_iterator;
+
+            static constexpr CapacityPolicy policy = Policy;
+
+            constexpr StaticIntervalUnion() = default;
+
+            template<BoundaryConcept IntBoundary>
+            constexpr StaticIntervalUnion(Interval<IntBoundary> interval) {
+                const Interval<Boundary>& I = interval;
+                if (!I.isempty()) { intervals.push_back(I); }
+            }
+
+            template<BoundaryConcept S, BoundaryConcept T>
+            constexpr StaticIntervalUnion(char left_bracket_in, S left_value_in, T right_value_in, char right_bracket_in):
+                StaticIntervalUnion(Interval<Boundary>(left_bracket_in, std::move(left_value_in), std::move(right_value_in), right_bracket_in))
+            { }
+
+            constexpr StaticIntervalUnion(std::initializer_list<Interval<Boundary>> l) {
+                // Each interval is merged in as it comes, as there is no room to sort them all first.
+                for (const auto& I : l) {
+                    if (I.isnan()) { *this = nan(); return; }
+                    *this = *this || StaticIntervalUnion(I);
+                }
+            }
+
+            template<BoundaryConcept RhsBoundary, std::size_t RhsCapacity, class RhsAllocator>
+            constexpr explicit StaticIntervalUnion(const IntervalUnion<RhsBoundary, RhsCapacity, RhsAllocator>& A) {
+                if (A.isnan()) { intervals.push_back(Interval<Boundary>::nan()); return; }
+                for (auto iter = A.cbegin(); iter != A.cend(); ++iter) {
+                    const Interval<Boundary>& I = *iter;
+                    append(I.left_value(), I.left_bracket() == '[', I.right_value(), I.right_bracket() == ']');
+                }
+                finish();
+            }
+
+            constexpr explicit operator IntervalUnion<Boundary>() const { return IntervalUnion<Boundary>(cbegin(), cend()); }
+
+            static constexpr size_type capacity(void) { return N; }
+
+            constexpr size_type size(void) const { return isnan() ? 0 : intervals.size(); }
+
+            constexpr const_iterator cbegin(void) const { return intervals.cbegin(); }
+            constexpr const_iterator cend(void) const { return intervals.cend(); }
+
+            constexpr value_type operator[](size_type i) const { return intervals[i]; }
+
+            constexpr bool isempty(void) const { return intervals.empty(); }
+
+            constexpr bool issingleton(void) const { return intervals.size() == 1 && intervals.front().issingleton(); }
+
+            constexpr bool isnan(void) const { return !isempty() && boundary_traits<Boundary>::isnan(intervals.left_value(0)); }
+
+            // Whether this union or one it was computed from needed more than N intervals. Under
+            // CapacityPolicy::error such a union is NaN; under saturate it is a superset of the exact
+            // result of the operation that overflowed.
+            constexpr bool overflowed(void) const { return overflow_m; }
+
+            static constexpr StaticIntervalUnion empty(void) { return StaticIntervalUnion(); }
+
+            static constexpr StaticIntervalUnion universal(bool extended_real_line = false) { return empty().inv(extended_real_line); }
+
+            static constexpr StaticIntervalUnion nan(void) { return StaticIntervalUnion(Interval<Boundary>::nan()); }
+
+            constexpr StaticIntervalUnion inv(bool extended_real_line = false) const {
+                if (isnan()) { return *this; }
+                detail::ComplementIntervals<vector_type, Boundary> complement(intervals, extended_real_line);
+                StaticIntervalUnion ret;
+                ret.overflow_m = overflow_m;
+                for (std::size_t j = 0; j != complement.size(); ++j) {
+                    ret.append(complement.left_value(j), complement.left_closed(j), complement.right_value(j), complement.right_closed(j));
+                }
+                ret.finish();
+                return ret;
+            }
+
+            constexpr StaticIntervalUnion operator!() const {
+                return inv(
+                    !isempty() && (
+                        detail::contains_negative_infinity(intervals.left_value(0), intervals.left_closed(0)) ||
+                        (intervals.right_value(intervals.size() - 1) == boundary_traits<Boundary>::infinity() && intervals.right_closed(intervals.size() - 1))
+                    )
+                );
+            }
+
+            constexpr StaticIntervalUnion operator&&(const StaticIntervalUnion& rhs) const {
+                StaticIntervalUnion intersection;
+                if (isnan() || rhs.isnan()) {
+                    intersection = nan();
+                } else if (!isempty() && !rhs.isempty()) {
+                    detail::intersect_sorted(intervals, rhs.intervals, [&](const auto& l, bool lc, const auto& r, bool rc) {
+                        intersection.append(l, lc, r, rc);
+                    });
+                }
+                intersection.overflow_m |= overflow_m || rhs.overflow_m;
+                intersection.finish();
+                return intersection;
+            }
+
+            constexpr StaticIntervalUnion operator||(const StaticIntervalUnion& rhs) const {
+                StaticIntervalUnion set_union;
+                if (isnan() || rhs.isnan()) {
+                    set_union = nan();
+                } else {
+                    detail::merge_sorted(intervals, rhs.intervals, [&](const auto& l, bool lc, const auto& r, bool rc) {
+                        set_union.append(l, lc, r, rc);
+                    });
+                }
+                set_union.overflow_m |= overflow_m || rhs.overflow_m;
+                set_union.finish();
+                return set_union;
+            }
+
+            constexpr StaticIntervalUnion operator-(const StaticIntervalUnion& rhs) const {
+                // As for IntervalUnion, lhs && rhs.inv(true) with the complement read on demand.
+                StaticIntervalUnion difference;
+                if (isnan() || rhs.isnan()) {
+                    difference = nan();
+                } else if (!isempty()) {
+                    detail::ComplementIntervals<vector_type, Boundary> complement(rhs.intervals, true);
+                    detail::intersect_sorted(intervals, complement, [&](const auto& l, bool lc, const auto& r, bool rc) {
+                        difference.append(l, lc, r, rc);
+                    });
+                }
+                difference.overflow_m |= overflow_m || rhs.overflow_m;
+                difference.finish();
+                return difference;
+            }
+
+            constexpr StaticIntervalUnion& operator&=(const StaticIntervalUnion& rhs) { return *this = *this && rhs; }
+            constexpr StaticIntervalUnion& operator|=(const StaticIntervalUnion& rhs) { return *this = *this || rhs; }
+            constexpr StaticIntervalUnion& operator-=(const StaticIntervalUnion& rhs) { return *this = *this - rhs; }
+
+            constexpr bool operator==(const StaticIntervalUnion& rhs) const {
+                if (isnan() || rhs.isnan() || intervals.size() != rhs.intervals.size()) { return false; }
+                for (size_type i = 0; i != intervals.size(); ++i) {
+                    if (
+                        intervals.left_value(i) != rhs.intervals.left_value(i) ||
+                        intervals.right_value(i) != rhs.intervals.right_value(i) ||
+                        intervals.left_closed(i) != rhs.intervals.left_closed(i) ||
+                        intervals.right_closed(i) != rhs.intervals.right_closed(i)
+                    ) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            constexpr bool operator!=(const StaticIntervalUnion& rhs) const { return !isnan() && !rhs.isnan() && !operator==(rhs); }
+
+            template<BoundaryConcept BoundaryX>
+            constexpr Boundary operator()(const BoundaryX& x) const {
+                if (isnan()) { return false; }
+                const auto a = intervals.arrays();
+                std::size_t i = std::lower_bound(
+                    a.right_values,
+                    a.right_values + a.size,
+                    x,
+                    [](const Boundary& right_value, const BoundaryX& y) {
+                        return right_value < y;
+                    }
+                ) - a.right_values;
+                return i == a.size ? false : detail::contains_at(a, i, x);
+            }
+
+            // The predicates, as for IntervalUnion.
+
+            friend constexpr bool operator<=(const StaticIntervalUnion& lhs, const StaticIntervalUnion& rhs) {
+                return !lhs.isnan() && !rhs.isnan() && detail::is_subset_sorted(lhs.intervals, rhs.intervals);
+            }
+
+            friend constexpr bool operator>=(const StaticIntervalUnion& lhs, const StaticIntervalUnion& rhs) { return rhs <= lhs; }
+            friend constexpr bool operator<(const StaticIntervalUnion& lhs, const StaticIntervalUnion& rhs) { return lhs <= rhs && lhs != rhs; }
+            friend constexpr bool operator>(const StaticIntervalUnion& lhs, const StaticIntervalUnion& rhs) { return rhs < lhs; }
+
+            friend constexpr bool isdisjoint(const StaticIntervalUnion& lhs, const StaticIntervalUnion& rhs) {
+                return !lhs.isnan() && !rhs.isnan() && detail::is_disjoint_sorted(lhs.intervals, rhs.intervals);
+            }
+
+            friend constexpr bool overlaps(const StaticIntervalUnion& lhs, const StaticIntervalUnion& rhs) {
+                return !lhs.isnan() && !rhs.isnan() && !isdisjoint(lhs, rhs);
+            }
+
+        private:
+            vector_type intervals;
+            bool overflow_m = false;
+            bool overflowing = false;
+
+            template<class S, class T>
+            constexpr void append(const S& left_value, bool left_closed, const T& right_value, bool right_closed) {
+                // Appends an unempty interval whose left boundary is no earlier than that of the last,
+                // merging the two when they overlap or touch. An interval with no room left is merged
+                // into the last under CapacityPolicy::saturate, and dropped under error as finish makes
+                // the union NaN.
+                if (!intervals.empty()) {
+                    auto last = intervals.size() - 1;
+                    if (overflowing || detail::touches(intervals.right_value(last), intervals.right_closed(last), left_value, left_closed)) {
+                        if (detail::precedes_right(intervals.right_value(last), intervals.right_closed(last), right_value, right_closed)) {
+                            intervals.set_right(last, right_value, right_closed);
+                        }
+                        return;
+                    }
+                }
+                if (intervals.size() == N) {
+                    overflowing = true;
+                    if constexpr (Policy == CapacityPolicy::saturate) {
+                        intervals.set_right(N - 1, right_value, right_closed);
+                    }
+                    return;
+                }
+                intervals.push_back(left_value, left_closed, right_value, right_closed);
+            }
+
+            constexpr void finish(void) {
+                if (overflowing) {
+                    overflowing = false;
+                    overflow_m = true;
+                    if constexpr (Policy == CapacityPolicy::error) {
+                        intervals.clear();
+                        intervals.push_back(Interval<Boundary>::nan());
+                    }
+                }
+            }
+    };
+
+}
+
+#endif
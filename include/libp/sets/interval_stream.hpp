@@ -0,0 +1,476 @@
+#ifndef LIBP_SETS_INTERVAL_STREAM_HPP_GUARD
+#define LIBP_SETS_INTERVAL_STREAM_HPP_GUARD
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdio>
+#include <istream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <ranges>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <libp/sets/interval.hpp>
+#include <libp/sets/interval_charconv.hpp>
+#include <libp/sets/detail/interval_merge.hpp>
+
+namespace libp {
+
+    // Set operations on unions too large to hold in memory, read one interval at a time from input
+    // ranges of Intervals, such as istream views or generators, and written one interval at a time to
+    // an output iterator. The inputs must hold the intervals of a union in the order its iterators
+    // give them: sorted, nonempty and separated by gaps, or a single NaN interval for the NaN union.
+    // Each operation holds O(1) intervals however long its inputs, reads each input once, and writes
+    // the intervals of the same union the in-memory operation would give, in order, returning the
+    // output iterator past the last of them.
+
+    namespace detail {
+
+        template<class T>
+        struct interval_boundary { };
+
+        template<BoundaryConcept Boundary>
+        struct interval_boundary<Interval<Boundary>> { using type = Boundary; };
+
+    }
+
+    template<class Range>
+    concept IntervalRange = std::ranges::input_range<Range> &&
+        requires { typename detail::interval_boundary<std::ranges::range_value_t<Range>>::type; };
+
+    namespace detail {
+
+        template<class Range>
+        using interval_range_boundary_t = typename interval_boundary<std::ranges::range_value_t<Range>>::type;
+
+        template<class Range>
+        class RangeIntervals {
+            // The intervals of an input range as a cursor, dereferencing each position once.
+
+            public:
+                using boundary_type = interval_range_boundary_t<Range>;
+
+                explicit RangeIntervals(Range& range):
+                    iter(std::ranges::begin(range)),
+                    end(std::ranges::end(range))
+                {
+                    load();
+                }
+
+                bool done(void) const { return iter == end; }
+                const Interval<boundary_type>& current(void) const { return interval; }
+                void next(void) { ++iter; load(); }
+
+            private:
+                std::ranges::iterator_t<Range> iter;
+                std::ranges::sentinel_t<Range> end;
+                Interval<boundary_type> interval;
+
+                void load(void) { if (iter != end) { interval = *iter; } }
+        };
+
+        template<class Intervals>
+        class ComplementCursor {
+            // The gaps of a canonical, non-NaN cursor, with the brackets of ComplementIntervals.
+
+            public:
+                using boundary_type = typename Intervals::boundary_type;
+
+                ComplementCursor(Intervals& intervals_in, bool extended_real_line_in):
+                    intervals(intervals_in),
+                    extended_real_line(extended_real_line_in),
+                    left_value(boundary_traits<boundary_type>::negative_infinity()),
+                    left_closed(extended_real_line_in || boundary_traits<boundary_type>::bounded_below)
+                {
+                    next();
+                }
+
+                bool done(void) const { return finished; }
+                const Interval<boundary_type>& current(void) const { return gap; }
+
+                void next(void) {
+                    // Gaps between intervals are never empty, but those at the ends may be.
+                    while (!past_last) {
+                        boundary_type right_value = boundary_traits<boundary_type>::infinity();
+                        bool right_closed = extended_real_line;
+                        auto start = left_value;
+                        bool start_closed = left_closed;
+                        if (intervals.done()) {
+                            past_last = true;
+                        } else {
+                            const auto& I = intervals.current();
+                            right_value = I.left_value();
+                            right_closed = I.left_bracket() == '(';
+                            left_value = I.right_value();
+                            left_closed = I.right_bracket() == ')';
+                            intervals.next();
+                        }
+                        if (start < right_value || (start == right_value && start_closed && right_closed)) {
+                            gap = Interval<boundary_type>(start_closed ? '[' : '(', start, right_value, right_closed ? ']' : ')');
+                            return;
+                        }
+                    }
+                    finished = true;
+                }
+
+            private:
+                Intervals& intervals;
+                bool extended_real_line;
+                boundary_type left_value;
+                bool left_closed;
+                bool past_last = false;
+                bool finished = false;
+                Interval<boundary_type> gap;
+        };
+
+        template<class Boundary, class Out, class S, class T>
+        void emit_interval(Out& out, const S& left_value, bool left_closed, const T& right_value, bool right_closed) {
+            *out++ = Interval<Boundary>(left_closed ? '[' : '(', left_value, right_value, right_closed ? ']' : ')');
+        }
+
+        template<class Boundary, class Lhs, class Rhs, class Out>
+        Out intersect_cursors(Lhs& lhs, Rhs& rhs, Out out) {
+            // As intersect_sorted, on both operands' intervals converted to the common boundary type.
+            while (!lhs.done() && !rhs.done()) {
+                const Interval<Boundary> I = lhs.current();
+                const Interval<Boundary> J = rhs.current();
+                bool lhs_left_later = precedes_left(J.left_value(), J.left_bracket() == '[', I.left_value(), I.left_bracket() == '[');
+                bool lhs_right_earlier = precedes_right(I.right_value(), I.right_bracket() == ']', J.right_value(), J.right_bracket() == ']');
+                bool rhs_right_earlier = precedes_right(J.right_value(), J.right_bracket() == ']', I.right_value(), I.right_bracket() == ']');
+                bool left_closed = (lhs_left_later ? I.left_bracket() : J.left_bracket()) == '[';
+                bool right_closed = (lhs_right_earlier ? I.right_bracket() : J.right_bracket()) == ']';
+                Boundary left_value = lhs_left_later ? I.left_value() : J.left_value();
+                Boundary right_value = lhs_right_earlier ? I.right_value() : J.right_value();
+                if (left_value < right_value || (left_value == right_value && left_closed && right_closed)) {
+                    emit_interval<Boundary>(out, left_value, left_closed, right_value, right_closed);
+                }
+                if (!rhs_right_earlier) { lhs.next(); }
+                if (!lhs_right_earlier) { rhs.next(); }
+            }
+            return out;
+        }
+
+        template<class Boundary>
+        class Coalescer {
+            // Merges intervals arriving in order of left boundary into the canonical union, holding back
+            // the last interval until the next one shows whether it extends.
+
+            public:
+                template<class Out>
+                void push(Out& out, const Interval<Boundary>& I) {
+                    bool left_closed = I.left_bracket() == '[';
+                    bool right_closed = I.right_bracket() == ']';
+                    if (pending && touches(pending_right_value, pending_right_closed, I.left_value(), left_closed)) {
+                        if (precedes_right(pending_right_value, pending_right_closed, I.right_value(), right_closed)) {
+                            pending_right_value = I.right_value();
+                            pending_right_closed = right_closed;
+                        }
+                        return;
+                    }
+                    flush(out);
+                    pending = true;
+                    pending_left_value = I.left_value();
+                    pending_left_closed = left_closed;
+                    pending_right_value = I.right_value();
+                    pending_right_closed = right_closed;
+                }
+
+                template<class Out>
+                void flush(Out& out) {
+                    if (pending) { emit_interval<Boundary>(out, pending_left_value, pending_left_closed, pending_right_value, pending_right_closed); }
+                    pending = false;
+                }
+
+            private:
+                bool pending = false;
+                Boundary pending_left_value{};
+                bool pending_left_closed = false;
+                Boundary pending_right_value{};
+                bool pending_right_closed = false;
+        };
+
+        template<class Boundary, class Lhs, class Rhs, class Out>
+        Out unite_cursors(Lhs& lhs, Rhs& rhs, Out out) {
+            // As merge_sorted, coalescing as it goes, on intervals converted to the common boundary type.
+            Coalescer<Boundary> coalescer;
+            while (!lhs.done() || !rhs.done()) {
+                bool take_lhs = rhs.done();
+                if (!lhs.done() && !rhs.done()) {
+                    const Interval<Boundary> I = lhs.current();
+                    const Interval<Boundary> J = rhs.current();
+                    take_lhs = !precedes_left(J.left_value(), J.left_bracket() == '[', I.left_value(), I.left_bracket() == '[');
+                }
+                if (take_lhs) {
+                    coalescer.push(out, Interval<Boundary>(lhs.current()));
+                    lhs.next();
+                } else {
+                    coalescer.push(out, Interval<Boundary>(rhs.current()));
+                    rhs.next();
+                }
+            }
+            coalescer.flush(out);
+            return out;
+        }
+
+        template<class Cursor>
+        bool cursor_isnan(const Cursor& cursor) { return !cursor.done() && cursor.current().isnan(); }
+
+    }
+
+    template<IntervalRange Lhs, IntervalRange Rhs, class Out>
+    Out stream_intersection(Lhs&& lhs, Rhs&& rhs, Out out) {
+        using Boundary = detail::common_boundary_t<detail::interval_range_boundary_t<Lhs>, detail::interval_range_boundary_t<Rhs>>;
+        detail::RangeIntervals<std::remove_reference_t<Lhs>> a(lhs);
+        detail::RangeIntervals<std::remove_reference_t<Rhs>> b(rhs);
+        if (detail::cursor_isnan(a) || detail::cursor_isnan(b)) { *out++ = Interval<Boundary>::nan(); return out; }
+        return detail::intersect_cursors<Boundary>(a, b, std::move(out));
+    }
+
+    template<IntervalRange Lhs, IntervalRange Rhs, class Out>
+    Out stream_union(Lhs&& lhs, Rhs&& rhs, Out out) {
+        using Boundary = detail::common_boundary_t<detail::interval_range_boundary_t<Lhs>, detail::interval_range_boundary_t<Rhs>>;
+        detail::RangeIntervals<std::remove_reference_t<Lhs>> a(lhs);
+        detail::RangeIntervals<std::remove_reference_t<Rhs>> b(rhs);
+        if (detail::cursor_isnan(a) || detail::cursor_isnan(b)) { *out++ = Interval<Boundary>::nan(); return out; }
+        return detail::unite_cursors<Boundary>(a, b, std::move(out));
+    }
+
+    template<IntervalRange Lhs, IntervalRange Rhs, class Out>
+    Out stream_difference(Lhs&& lhs, Rhs&& rhs, Out out) {
+        // lhs && rhs.inv(true), as operator-.
+        using Boundary = detail::common_boundary_t<detail::interval_range_boundary_t<Lhs>, detail::interval_range_boundary_t<Rhs>>;
+        detail::RangeIntervals<std::remove_reference_t<Lhs>> a(lhs);
+        detail::RangeIntervals<std::remove_reference_t<Rhs>> b(rhs);
+        if (detail::cursor_isnan(a) || detail::cursor_isnan(b)) { *out++ = Interval<Boundary>::nan(); return out; }
+        detail::ComplementCursor<decltype(b)> complement(b, true);
+        return detail::intersect_cursors<Boundary>(a, complement, std::move(out));
+    }
+
+    template<IntervalRange Range, class Out>
+    Out stream_complement(Range&& range, Out out, bool extended_real_line = false) {
+        // As IntervalUnion::inv(extended_real_line).
+        using Boundary = detail::interval_range_boundary_t<Range>;
+        detail::RangeIntervals<std::remove_reference_t<Range>> a(range);
+        if (detail::cursor_isnan(a)) { *out++ = Interval<Boundary>::nan(); return out; }
+        for (detail::ComplementCursor<decltype(a)> complement(a, extended_real_line); !complement.done(); complement.next()) {
+            *out++ = complement.current();
+        }
+        return out;
+    }
+
+    namespace detail {
+
+        template<std::floating_point Boundary>
+        class TextIntervalReader {
+            // Parses the intervals of a stream in the text of operator<<, through a buffer that grows only
+            // to hold the longest interval. An interval is only parsed once its closing bracket is in
+            // the buffer, so a boundary is never cut short by the end of a read. The ';' that ends each
+            // union written by operator<< is read as a separator, so a file of unions reads as all of
+            // their intervals, and the (0,0) of an empty union as an empty interval.
+
+            public:
+                explicit TextIntervalReader(std::istream& is_in): is(is_in), buffer(1 << 16) { }
+
+                std::errc next(Interval<Boundary>& I, bool& found) {
+                    for (;;) {
+                        const char* first = buffer.data() + begin;
+                        const char* last = buffer.data() + end;
+                        while ((first = skip_whitespace(first, last)) != last && *first == ';') { ++first; }
+                        begin = first - buffer.data();
+                        if (!eof && std::find_if(first, last, [](char c) { return c == ')' || c == ']'; }) == last) {
+                            refill();
+                            continue;
+                        }
+                        found = first != last;
+                        if (!found) { return std::errc(); }
+                        auto [p, ec] = from_chars(first, last, I);
+                        begin = p - buffer.data();
+                        return ec;
+                    }
+                }
+
+            private:
+                std::istream& is;
+                std::vector<char> buffer;
+                std::size_t begin = 0;
+                std::size_t end = 0;
+                bool eof = false;
+
+                void refill(void) {
+                    std::copy(buffer.begin() + begin, buffer.begin() + end, buffer.begin());
+                    end -= begin;
+                    begin = 0;
+                    if (end == buffer.size()) { buffer.resize(2*buffer.size()); }
+                    is.read(buffer.data() + end, buffer.size() - end);
+                    end += is.gcount();
+                    eof = is.gcount() == 0;
+                }
+        };
+
+        template<std::floating_point Boundary>
+        class TextIntervalWriter {
+            // Writes intervals to a stream one per line, as an output iterator.
+
+            public:
+                using iterator_category = std::output_iterator_tag;
+                using value_type = void;
+                using difference_type = std::ptrdiff_t;
+                using pointer = void;
+                using reference = void;
+
+                explicit TextIntervalWriter(std::ostream& os_in): os(&os_in) { }
+
+                TextIntervalWriter& operator*(void) { return *this; }
+                TextIntervalWriter& operator++(void) { return *this; }
+                TextIntervalWriter& operator++(int) { return *this; }
+
+                TextIntervalWriter& operator=(const Interval<Boundary>& I) {
+                    char text[interval_chars<Boundary> + 1];
+                    char* p = write_interval(text, text + interval_chars<Boundary>, I);
+                    *p++ = '\n';
+                    os->write(text, p - text);
+                    return *this;
+                }
+
+            private:
+                std::ostream* os;
+        };
+
+        struct FileCloser {
+            void operator()(std::FILE* file) const { std::fclose(file); }
+        };
+
+        using TemporaryFile = std::unique_ptr<std::FILE, FileCloser>;
+
+        template<class Boundary>
+        bool write_run(std::FILE* file, const Interval<Boundary>& I) {
+            // Runs are stored as fixed-size records of the two boundaries and the two brackets.
+            Boundary values[2] = {I.left_value(), I.right_value()};
+            char brackets[2] = {I.left_bracket(), I.right_bracket()};
+            return std::fwrite(values, sizeof(Boundary), 2, file) == 2 && std::fwrite(brackets, 1, 2, file) == 2;
+        }
+
+        template<class Boundary>
+        class RunIntervals {
+            // The intervals of a sorted run read back from its temporary file, as a cursor.
+
+            public:
+                using boundary_type = Boundary;
+
+                explicit RunIntervals(std::FILE* file_in): file(file_in) { std::rewind(file); next(); }
+
+                bool done(void) const { return finished; }
+                const Interval<Boundary>& current(void) const { return interval; }
+
+                void next(void) {
+                    Boundary values[2];
+                    char brackets[2];
+                    finished = std::fread(values, sizeof(Boundary), 2, file) != 2 || std::fread(brackets, 1, 2, file) != 2;
+                    if (!finished) { interval = Interval<Boundary>(brackets[0], values[0], values[1], brackets[1]); }
+                }
+
+            private:
+                std::FILE* file;
+                Interval<Boundary> interval;
+                bool finished = false;
+        };
+
+    }
+
+    template<std::floating_point Boundary>
+    std::errc external_canonicalise(std::istream& is, std::ostream& os, std::size_t run_intervals = std::size_t(1) << 20) {
+        // Reads intervals in any order from is, in the text of operator<< for intervals or for
+        // unions, and writes the canonical union of them to os one interval per line, in text that
+        // operator>> and from_chars read back as that union. The empty union is written as (0,0);,
+        // as to_chars writes it. At most run_intervals intervals are held in memory at once: each
+        // run of that many is canonicalised in memory and spilled to a temporary file, and the runs
+        // are then merged in one pass holding an interval of each. A NaN interval makes the union
+        // NaN. Reports std::errc::invalid_argument if is holds anything but intervals, and
+        // std::errc::io_error if a temporary file cannot be written or os fails; os may then hold
+        // part of the result.
+        detail::TextIntervalReader<Boundary> reader(is);
+        detail::TextIntervalWriter<Boundary> writer(os);
+        std::vector<detail::TemporaryFile> runs;
+        std::vector<Interval<Boundary>> buffer;
+        buffer.reserve(std::min<std::size_t>(std::max<std::size_t>(run_intervals, 1), std::size_t(1) << 20));
+        bool nan = false;
+        bool found = true;
+        while (found && !nan) {
+            buffer.clear();
+            Interval<Boundary> I;
+            while (buffer.size() < std::max<std::size_t>(run_intervals, 1)) {
+                if (auto ec = reader.next(I, found); ec != std::errc()) { return ec; }
+                if (!found) { break; }
+                if (I.isnan()) { nan = true; break; }
+                if (!I.isempty()) { buffer.push_back(I); }
+            }
+            if (nan || (runs.empty() && !found)) { break; }
+            IntervalUnion<Boundary> run(buffer.cbegin(), buffer.cend());
+            detail::TemporaryFile file(std::tmpfile());
+            if (!file) { return std::errc::io_error; }
+            for (auto iter = run.cbegin(); iter != run.cend(); ++iter) {
+                if (!detail::write_run(file.get(), *iter)) { return std::errc::io_error; }
+            }
+            if (std::fflush(file.get()) != 0) { return std::errc::io_error; }
+            runs.push_back(std::move(file));
+        }
+
+        if (nan) {
+            *writer = Interval<Boundary>::nan();
+        } else if (runs.empty()) {
+            // The input fitted in one run, which needs no temporary file.
+            IntervalUnion<Boundary> A(buffer.cbegin(), buffer.cend());
+            if (A.isempty()) {
+                // With no intervals to write, an empty output would not read back as a union.
+                char text[detail::interval_chars<Boundary> + 2];
+                auto [p, ec] = to_chars(text, text + detail::interval_chars<Boundary> + 1, A);
+                *p++ = '\n';
+                os.write(text, p - text);
+            } else {
+                std::copy(A.cbegin(), A.cend(), writer);
+            }
+        } else {
+            // Merge the runs through a heap ordered by left boundary, which is a k-way merge_sorted.
+            std::vector<detail::RunIntervals<Boundary>> cursors;
+            cursors.reserve(runs.size());
+            for (const auto& file : runs) { cursors.emplace_back(file.get()); }
+            auto later = [&](std::size_t s, std::size_t t) {
+                const auto& I = cursors[s].current();
+                const auto& J = cursors[t].current();
+                return detail::precedes_left(J.left_value(), J.left_bracket() == '[', I.left_value(), I.left_bracket() == '[');
+            };
+            std::vector<std::size_t> heap;
+            for (std::size_t s = 0; s != cursors.size(); ++s) {
+                if (!cursors[s].done()) { heap.push_back(s); }
+            }
+            std::make_heap(heap.begin(), heap.end(), later);
+            detail::Coalescer<Boundary> coalescer;
+            while (!heap.empty()) {
+                std::pop_heap(heap.begin(), heap.end(), later);
+                auto s = heap.back();
+                coalescer.push(writer, cursors[s].current());
+                cursors[s].next();
+                if (cursors[s].done()) {
+                    heap.pop_back();
+                } else {
+                    std::push_heap(heap.begin(), heap.end(), later);
+                }
+            }
+            coalescer.flush(writer);
+            for (const auto& file : runs) {
+                if (std::ferror(file.get())) { return std::errc::io_error; }
+            }
+        }
+        os.flush();
+        return os ? std::errc() : std::errc::io_error;
+    }
+
+}
+
+#endif
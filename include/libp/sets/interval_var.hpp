@@ -0,0 +1,273 @@
+#ifndef LIBP_SETS_INTERVAL_VAR_HPP_GUARD
+#define LIBP_SETS_INTERVAL_VAR_HPP_GUARD
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include <stan/math.hpp>
+
+#include <libp/sets/interval.hpp>
+
+namespace libp {
+
+    namespace detail {
+
+        struct TaggedBoundary {
+            // A boundary value together with the vari it was read from, which is null for a constant.
+            // Only the value takes part in comparisons, so the merges order tagged boundaries as they
+            // would doubles and hand back the handles untouched.
+            double value;
+            stan::math::vari* handle;
+
+            friend bool operator<(const TaggedBoundary& a, const TaggedBoundary& b) { return a.value < b.value; }
+            friend bool operator==(const TaggedBoundary& a, const TaggedBoundary& b) { return a.value == b.value; }
+        };
+
+    }
+
+    template<>
+    struct boundary_traits<detail::TaggedBoundary> {
+        // The infinities of a complement are constants.
+        static constexpr bool native_sentinels = true;
+        static constexpr bool discrete = false;
+        static constexpr bool bounded_below = false;
+        static detail::TaggedBoundary infinity(void) { return {std::numeric_limits<double>::infinity(), nullptr}; }
+        static detail::TaggedBoundary negative_infinity(void) { return {-std::numeric_limits<double>::infinity(), nullptr}; }
+        static detail::TaggedBoundary nan(void) { return {std::numeric_limits<double>::quiet_NaN(), nullptr}; }
+        static bool isnan(const detail::TaggedBoundary& x) { return std::isnan(x.value); }
+    };
+
+    class VarIntervalUnion {
+        // A union with stan::math::var boundaries, stored as an IntervalUnion<double> of their values
+        // alongside two arrays of vari handles, one per boundary. The set operations compare the packed
+        // doubles and copy handles without following them, so they never touch the autodiff stack,
+        // whereas IntervalUnion<var> reads every value through its vari. Each boundary of a result is
+        // the var of the operand boundary it came from; the infinities a complement introduces are
+        // constants.
+
+        using vector_type = IntervalUnion<double>::vector_type;
+        using handles_type = std::vector<stan::math::vari*>;
+
+        class Intervals {
+            // The intervals with tagged boundaries, in the form the merges read.
+
+            public:
+                Intervals(const VarIntervalUnion& A_in): A(A_in) { }
+
+                std::size_t size(void) const { return A.values.size(); }
+                detail::TaggedBoundary left_value(std::size_t i) const { return {A.values.left_value(i), A.left_handles[i]}; }
+                detail::TaggedBoundary right_value(std::size_t i) const { return {A.values.right_value(i), A.right_handles[i]}; }
+                bool left_closed(std::size_t i) const { return A.values.left_closed(i); }
+                bool right_closed(std::size_t i) const { return A.values.right_closed(i); }
+
+            private:
+                const VarIntervalUnion& A;
+        };
+
+        public:
+            using boundary_type = stan::math::var;
+
+            VarIntervalUnion() = default;
+
+            template<std::size_t InlineCapacity, class Allocator>
+            explicit VarIntervalUnion(const IntervalUnion<stan::math::var, InlineCapacity, Allocator>& A) {
+                if (A.isnan()) { nan_m = true; return; }
+                const auto& intervals = detail::IntervalUnionAccess::intervals(A);
+                values.reserve(intervals.size());
+                left_handles.reserve(intervals.size());
+                right_handles.reserve(intervals.size());
+                for (std::size_t i = 0; i != intervals.size(); ++i) {
+                    const auto& l = intervals.left_value(i);
+                    const auto& r = intervals.right_value(i);
+                    values.push_back(l.val(), intervals.left_closed(i), r.val(), intervals.right_closed(i));
+                    left_handles.push_back(l.vi_);
+                    right_handles.push_back(r.vi_);
+                }
+            }
+
+            explicit operator IntervalUnion<stan::math::var>() const {
+                // Boundaries with a handle are the original vars; the constant infinities get new ones.
+                if (nan_m) { return IntervalUnion<stan::math::var>::nan(); }
+                IntervalUnion<stan::math::var> A;
+                auto& intervals = detail::IntervalUnionAccess::intervals(A);
+                intervals.reserve(values.size());
+                for (std::size_t i = 0; i != values.size(); ++i) {
+                    intervals.push_back(var_of(values.left_value(i), left_handles[i]), values.left_closed(i), var_of(values.right_value(i), right_handles[i]), values.right_closed(i));
+                }
+                return A;
+            }
+
+            std::size_t size(void) const { return values.size(); }
+
+            bool isempty(void) const { return values.empty() && !nan_m; }
+
+            bool issingleton(void) const { return values.size() == 1 && values.left_value(0) == values.right_value(0); }
+
+            bool isnan(void) const { return nan_m; }
+
+            static VarIntervalUnion empty(void) { return VarIntervalUnion(); }
+
+            static VarIntervalUnion universal(bool extended_real_line = false) { return empty().inv(extended_real_line); }
+
+            static VarIntervalUnion nan(void) { VarIntervalUnion A; A.nan_m = true; return A; }
+
+            // The values of the boundaries, without their handles.
+            IntervalUnion<double> value(void) const {
+                if (nan_m) { return IntervalUnion<double>::nan(); }
+                IntervalUnion<double> A;
+                detail::IntervalUnionAccess::intervals(A) = values;
+                return A;
+            }
+
+            VarIntervalUnion inv(bool extended_real_line = false) const {
+                if (nan_m) { return *this; }
+                Intervals intervals(*this);
+                detail::ComplementIntervals<Intervals, detail::TaggedBoundary> complement(intervals, extended_real_line);
+                VarIntervalUnion ret;
+                ret.reserve(complement.size());
+                for (std::size_t j = 0; j != complement.size(); ++j) {
+                    ret.push_back(complement.left_value(j), complement.left_closed(j), complement.right_value(j), complement.right_closed(j));
+                }
+                return ret;
+            }
+
+            VarIntervalUnion operator!() const {
+                const auto n = values.size();
+                return inv(
+                    n != 0 && (
+                        (values.left_value(0) == -std::numeric_limits<double>::infinity() && values.left_closed(0)) ||
+                        (values.right_value(n - 1) == std::numeric_limits<double>::infinity() && values.right_closed(n - 1))
+                    )
+                );
+            }
+
+            VarIntervalUnion operator&&(const VarIntervalUnion& rhs) const {
+                if (nan_m || rhs.nan_m) { return nan(); }
+                VarIntervalUnion intersection;
+                if (!isempty() && !rhs.isempty()) {
+                    intersection.reserve(size() + rhs.size() - 1);
+                    detail::intersect_sorted(Intervals(*this), Intervals(rhs), [&](const auto& l, bool lc, const auto& r, bool rc) {
+                        intersection.push_back(l, lc, r, rc);
+                    });
+                }
+                return intersection;
+            }
+
+            VarIntervalUnion operator||(const VarIntervalUnion& rhs) const {
+                if (nan_m || rhs.nan_m) { return nan(); }
+                VarIntervalUnion set_union;
+                set_union.reserve(size() + rhs.size());
+                detail::merge_sorted(Intervals(*this), Intervals(rhs), [&](const auto& l, bool lc, const auto& r, bool rc) {
+                    set_union.append_sorted_unempty_interval(l, lc, r, rc);
+                });
+                return set_union;
+            }
+
+            VarIntervalUnion operator-(const VarIntervalUnion& rhs) const {
+                // As for IntervalUnion, lhs && rhs.inv(true) with the complement read on demand.
+                if (nan_m || rhs.nan_m) { return nan(); }
+                VarIntervalUnion difference;
+                if (!isempty()) {
+                    Intervals rhs_intervals(rhs);
+                    detail::ComplementIntervals<Intervals, detail::TaggedBoundary> complement(rhs_intervals, true);
+                    difference.reserve(size() + complement.size());
+                    detail::intersect_sorted(Intervals(*this), complement, [&](const auto& l, bool lc, const auto& r, bool rc) {
+                        difference.push_back(l, lc, r, rc);
+                    });
+                }
+                return difference;
+            }
+
+            // Equality compares the values, not the handles, as it would for IntervalUnion<var>.
+            bool operator==(const VarIntervalUnion& rhs) const {
+                if (nan_m || rhs.nan_m || values.size() != rhs.values.size()) { return false; }
+                for (std::size_t i = 0; i != values.size(); ++i) {
+                    if (
+                        values.left_value(i) != rhs.values.left_value(i) ||
+                        values.right_value(i) != rhs.values.right_value(i) ||
+                        values.left_closed(i) != rhs.values.left_closed(i) ||
+                        values.right_closed(i) != rhs.values.right_closed(i)
+                    ) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            bool operator!=(const VarIntervalUnion& rhs) const { return !nan_m && !rhs.nan_m && !operator==(rhs); }
+
+            double operator()(double x) const {
+                if (nan_m) { return false; }
+                const auto a = values.arrays();
+                std::size_t i = std::lower_bound(a.right_values, a.right_values + a.size, x) - a.right_values;
+                return i == a.size ? false : detail::contains_at(a, i, x);
+            }
+
+            stan::math::var measure(void) const {
+                // The total length of the intervals, whose gradient is -1 with respect to every left
+                // boundary and 1 with respect to every right boundary. The handles are copied to the
+                // autodiff arena, which holds them until the gradient is taken, and the reverse pass
+                // adds the adjoint to all of them in one sweep.
+                if (nan_m) { return std::numeric_limits<double>::quiet_NaN(); }
+                const std::size_t n = values.size();
+                double total = 0;
+                for (std::size_t i = 0; i != n; ++i) { total += values.right_value(i) - values.left_value(i); }
+                auto& arena = stan::math::ChainableStack::instance_->memalloc_;
+                stan::math::vari** lefts = arena.alloc_array<stan::math::vari*>(n);
+                stan::math::vari** rights = arena.alloc_array<stan::math::vari*>(n);
+                std::copy(left_handles.begin(), left_handles.end(), lefts);
+                std::copy(right_handles.begin(), right_handles.end(), rights);
+                return stan::math::make_callback_var(total, [n, lefts, rights](const auto& vi) {
+                    const double adj = vi.adj();
+                    for (std::size_t i = 0; i != n; ++i) {
+                        if (lefts[i] != nullptr) { lefts[i]->adj_ -= adj; }
+                        if (rights[i] != nullptr) { rights[i]->adj_ += adj; }
+                    }
+                });
+            }
+
+        private:
+            vector_type values;
+            handles_type left_handles;
+            handles_type right_handles;
+            bool nan_m = false;
+
+            static stan::math::var var_of(double value, stan::math::vari* handle) {
+                return handle != nullptr ? stan::math::var(handle) : stan::math::var(value);
+            }
+
+            void reserve(std::size_t n) {
+                values.reserve(n);
+                left_handles.reserve(n);
+                right_handles.reserve(n);
+            }
+
+            void push_back(const detail::TaggedBoundary& l, bool lc, const detail::TaggedBoundary& r, bool rc) {
+                values.push_back(l.value, lc, r.value, rc);
+                left_handles.push_back(l.handle);
+                right_handles.push_back(r.handle);
+            }
+
+            void append_sorted_unempty_interval(const detail::TaggedBoundary& l, bool lc, const detail::TaggedBoundary& r, bool rc) {
+                // As IntervalUnion's: merges with the last interval when the two overlap or touch, in
+                // which case the later right boundary and its handle are kept.
+                if (!values.empty()) {
+                    auto last = values.size() - 1;
+                    if (detail::touches(values.right_value(last), values.right_closed(last), l.value, lc)) {
+                        if (detail::precedes_right(values.right_value(last), values.right_closed(last), r.value, rc)) {
+                            values.set_right(last, r.value, rc);
+                            right_handles[last] = r.handle;
+                        }
+                        return;
+                    }
+                }
+                push_back(l, lc, r, rc);
+            }
+    };
+
+}
+
+#endif
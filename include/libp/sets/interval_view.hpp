@@ -0,0 +1,416 @@
+#ifndef LIBP_SETS_INTERVAL_VIEW_HPP_GUARD
+#define LIBP_SETS_INTERVAL_VIEW_HPP_GUARD
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <type_traits>
+
+#include <libp/sets/interval.hpp>
+#include <libp/sets/interval_binary.hpp>
+
+#if __has_include(<sys/mman.h>) && __has_include(<sys/stat.h>) && __has_include(<fcntl.h>) && __has_include(<unistd.h>)
+    #define LIBP_HAS_MMAP 1
+    #include <cerrno>
+    #include <filesystem>
+    #include <system_error>
+    #include <utility>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace libp {
+
+    template<BoundaryConcept Boundary>
+    class IntervalUnionView {
+        // A read-only union over arrays it does not own, laid out as in an IntervalUnion, so that a
+        // union held in a buffer or a mapped file can be queried and combined without first being
+        // copied. The arrays must outlive the view and hold a canonical union: nonempty intervals with
+        // no NaN boundary, in order and separated by gaps. Given n intervals, the value arrays hold n
+        // values each and the bracket arrays (n + 63)/64 words each. The set operations return owning
+        // unions.
+
+        public:
+            using boundary_type = Boundary;
+            using value_type = Interval<Boundary>;
+            using size_type = std::size_t;
+            using const_iterator = detail::IntervalIterator<IntervalUnionView>;
+
+            constexpr IntervalUnionView() = default;
+
+            template<std::size_t InlineCapacity, class Allocator>
+            constexpr explicit IntervalUnionView(const IntervalUnion<Boundary, InlineCapacity, Allocator>& A):
+                nan_m(A.isnan())
+            {
+                if (!nan_m) { a = detail::IntervalUnionAccess::intervals(A).arrays(); }
+            }
+
+            constexpr IntervalUnionView(
+                std::span<const Boundary> left_values,
+                std::span<const Boundary> right_values,
+                std::span<const std::uint64_t> left_closed,
+                std::span<const std::uint64_t> right_closed
+            ):
+                a{left_values.data(), right_values.data(), left_closed.data(), right_closed.data(), left_values.size()}
+            { }
+
+            static constexpr IntervalUnionView nan(void) { IntervalUnionView V; V.nan_m = true; return V; }
+
+            constexpr size_type size(void) const { return a.size; }
+            constexpr const Boundary& left_value(size_type i) const { return a.left_values[i]; }
+            constexpr const Boundary& right_value(size_type i) const { return a.right_values[i]; }
+            constexpr bool left_closed(size_type i) const { return a.left_closed_at(i); }
+            constexpr bool right_closed(size_type i) const { return a.right_closed_at(i); }
+
+            constexpr value_type operator[](size_type i) const {
+                return value_type(left_closed(i) ? '[' : '(', left_value(i), right_value(i), right_closed(i) ? ']' : ')');
+            }
+
+            constexpr const_iterator cbegin(void) const { return const_iterator(this, 0); }
+            constexpr const_iterator cend(void) const { return const_iterator(this, size()); }
+
+            constexpr detail::IntervalArrays<Boundary> arrays(void) const { return a; }
+
+            constexpr bool isempty(void) const { return a.size == 0 && !nan_m; }
+
+            constexpr bool issingleton(void) const { return a.size == 1 && a.left_values[0] == a.right_values[0]; }
+
+            constexpr bool isnan(void) const { return nan_m; }
+
+            template<BoundaryConcept BoundaryX>
+            constexpr Boundary operator()(const BoundaryX& x) const {
+                std::size_t i = std::lower_bound(
+                    a.right_values,
+                    a.right_values + a.size,
+                    x,
+                    [](const Boundary& right_value, const BoundaryX& y) {
+                        return right_value < y;
+                    }
+                ) - a.right_values;
+                return i == a.size ? false : detail::contains_at(a, i, x);
+            }
+
+            constexpr IntervalUnion<Boundary> inv(bool extended_real_line = false) const {
+                if (nan_m) { return IntervalUnion<Boundary>::nan(); }
+                detail::ComplementIntervals<IntervalUnionView, Boundary> complement(*this, extended_real_line);
+                IntervalUnion<Boundary> ret;
+                auto& intervals = detail::IntervalUnionAccess::intervals(ret);
+                intervals.reserve(complement.size());
+                for (std::size_t j = 0; j != complement.size(); ++j) {
+                    intervals.push_back(
+                        complement.left_value(j),
+                        complement.left_closed(j),
+                        complement.right_value(j),
+                        complement.right_closed(j)
+                    );
+                }
+                return ret;
+            }
+
+            constexpr IntervalUnion<Boundary> operator!() const {
+                return inv(
+                    a.size != 0 && (
+                        detail::contains_negative_infinity(left_value(0), left_closed(0)) ||
+                        (right_value(a.size - 1) == boundary_traits<Boundary>::infinity() && right_closed(a.size - 1))
+                    )
+                );
+            }
+
+        private:
+            detail::IntervalArrays<Boundary> a{nullptr, nullptr, nullptr, nullptr, 0};
+            bool nan_m = false;
+    };
+
+    namespace detail {
+
+        // The set operations between views and unions, on the interval sequences of each operand and
+        // whether it is NaN. A NaN union holds a NaN interval, which is never read.
+
+        template<class Result, class Lhs, class Rhs>
+        constexpr Result intersect_operands(const Lhs& lhs, bool lhs_nan, const Rhs& rhs, bool rhs_nan, const typename Result::allocator_type& allocator) {
+            if (lhs_nan || rhs_nan) { return Result::nan(allocator); }
+            Result intersection(allocator);
+            if (lhs.size() != 0 && rhs.size() != 0) {
+                auto& intervals = IntervalUnionAccess::intervals(intersection);
+                intervals.reserve(lhs.size() + rhs.size() - 1);
+                intersect_sorted(lhs, rhs, [&](const auto& l, bool lc, const auto& r, bool rc) {
+                    intervals.push_back(l, lc, r, rc);
+                });
+            }
+            return intersection;
+        }
+
+        template<class Result, class Lhs, class Rhs>
+        constexpr Result unite_operands(const Lhs& lhs, bool lhs_nan, const Rhs& rhs, bool rhs_nan, const typename Result::allocator_type& allocator) {
+            if (lhs_nan || rhs_nan) { return Result::nan(allocator); }
+            Result set_union(allocator);
+            IntervalUnionAccess::intervals(set_union).reserve(lhs.size() + rhs.size());
+            merge_sorted(lhs, rhs, [&](const auto& l, bool lc, const auto& r, bool rc) {
+                IntervalUnionAccess::append_sorted_unempty_interval(set_union, l, lc, r, rc);
+            });
+            return set_union;
+        }
+
+        template<class Result, class RhsBoundary, class Lhs, class Rhs>
+        constexpr Result subtract_operands(const Lhs& lhs, bool lhs_nan, const Rhs& rhs, bool rhs_nan, const typename Result::allocator_type& allocator) {
+            // As operator- on unions.
+            if (lhs_nan || rhs_nan) { return Result::nan(allocator); }
+            return intersect_operands<Result>(lhs, false, ComplementIntervals<Rhs, RhsBoundary>(rhs, true), false, allocator);
+        }
+
+    }
+
+    // &&, || and - between two views, or a view and a union. Results are unions of the common boundary
+    // type, allocated from the allocator of the union operand if there is one.
+
+    template<BoundaryConcept LhsBoundary, BoundaryConcept RhsBoundary>
+    constexpr auto operator&&(const IntervalUnionView<LhsBoundary>& lhs, const IntervalUnionView<RhsBoundary>& rhs) {
+        using Result = IntervalUnion<detail::common_boundary_t<LhsBoundary, RhsBoundary>>;
+        return detail::intersect_operands<Result>(lhs, lhs.isnan(), rhs, rhs.isnan(), {});
+    }
+
+    template<BoundaryConcept LhsBoundary, BoundaryConcept RhsBoundary, std::size_t RhsCapacity, class RhsAllocator>
+    constexpr auto operator&&(const IntervalUnionView<LhsBoundary>& lhs, const IntervalUnion<RhsBoundary, RhsCapacity, RhsAllocator>& rhs) {
+        using Result = detail::common_interval_union_t<IntervalUnion<RhsBoundary, RhsCapacity, RhsAllocator>, LhsBoundary>;
+        const auto& rhs_intervals = detail::IntervalUnionAccess::intervals(rhs);
+        return detail::intersect_operands<Result>(lhs, lhs.isnan(), rhs_intervals, rhs.isnan(), typename Result::allocator_type(rhs.get_allocator()));
+    }
+
+    template<BoundaryConcept LhsBoundary, std::size_t LhsCapacity, class LhsAllocator, BoundaryConcept RhsBoundary>
+    constexpr auto operator&&(const IntervalUnion<LhsBoundary, LhsCapacity, LhsAllocator>& lhs, const IntervalUnionView<RhsBoundary>& rhs) {
+        using Result = detail::common_interval_union_t<IntervalUnion<LhsBoundary, LhsCapacity, LhsAllocator>, RhsBoundary>;
+        const auto& lhs_intervals = detail::IntervalUnionAccess::intervals(lhs);
+        return detail::intersect_operands<Result>(lhs_intervals, lhs.isnan(), rhs, rhs.isnan(), typename Result::allocator_type(lhs.get_allocator()));
+    }
+
+    template<BoundaryConcept LhsBoundary, BoundaryConcept RhsBoundary>
+    constexpr auto operator||(const IntervalUnionView<LhsBoundary>& lhs, const IntervalUnionView<RhsBoundary>& rhs) {
+        using Result = IntervalUnion<detail::common_boundary_t<LhsBoundary, RhsBoundary>>;
+        return detail::unite_operands<Result>(lhs, lhs.isnan(), rhs, rhs.isnan(), {});
+    }
+
+    template<BoundaryConcept LhsBoundary, BoundaryConcept RhsBoundary, std::size_t RhsCapacity, class RhsAllocator>
+    constexpr auto operator||(const IntervalUnionView<LhsBoundary>& lhs, const IntervalUnion<RhsBoundary, RhsCapacity, RhsAllocator>& rhs) {
+        using Result = detail::common_interval_union_t<IntervalUnion<RhsBoundary, RhsCapacity, RhsAllocator>, LhsBoundary>;
+        const auto& rhs_intervals = detail::IntervalUnionAccess::intervals(rhs);
+        return detail::unite_operands<Result>(lhs, lhs.isnan(), rhs_intervals, rhs.isnan(), typename Result::allocator_type(rhs.get_allocator()));
+    }
+
+    template<BoundaryConcept LhsBoundary, std::size_t LhsCapacity, class LhsAllocator, BoundaryConcept RhsBoundary>
+    constexpr auto operator||(const IntervalUnion<LhsBoundary, LhsCapacity, LhsAllocator>& lhs, const IntervalUnionView<RhsBoundary>& rhs) {
+        using Result = detail::common_interval_union_t<IntervalUnion<LhsBoundary, LhsCapacity, LhsAllocator>, RhsBoundary>;
+        const auto& lhs_intervals = detail::IntervalUnionAccess::intervals(lhs);
+        return detail::unite_operands<Result>(lhs_intervals, lhs.isnan(), rhs, rhs.isnan(), typename Result::allocator_type(lhs.get_allocator()));
+    }
+
+    template<BoundaryConcept LhsBoundary, BoundaryConcept RhsBoundary>
+    constexpr auto operator-(const IntervalUnionView<LhsBoundary>& lhs, const IntervalUnionView<RhsBoundary>& rhs) {
+        using Result = IntervalUnion<detail::common_boundary_t<LhsBoundary, RhsBoundary>>;
+        return detail::subtract_operands<Result, RhsBoundary>(lhs, lhs.isnan(), rhs, rhs.isnan(), {});
+    }
+
+    template<BoundaryConcept LhsBoundary, BoundaryConcept RhsBoundary, std::size_t RhsCapacity, class RhsAllocator>
+    constexpr auto operator-(const IntervalUnionView<LhsBoundary>& lhs, const IntervalUnion<RhsBoundary, RhsCapacity, RhsAllocator>& rhs) {
+        using Result = detail::common_interval_union_t<IntervalUnion<RhsBoundary, RhsCapacity, RhsAllocator>, LhsBoundary>;
+        const auto& rhs_intervals = detail::IntervalUnionAccess::intervals(rhs);
+        return detail::subtract_operands<Result, RhsBoundary>(lhs, lhs.isnan(), rhs_intervals, rhs.isnan(), typename Result::allocator_type(rhs.get_allocator()));
+    }
+
+    template<BoundaryConcept LhsBoundary, std::size_t LhsCapacity, class LhsAllocator, BoundaryConcept RhsBoundary>
+    constexpr auto operator-(const IntervalUnion<LhsBoundary, LhsCapacity, LhsAllocator>& lhs, const IntervalUnionView<RhsBoundary>& rhs) {
+        using Result = detail::common_interval_union_t<IntervalUnion<LhsBoundary, LhsCapacity, LhsAllocator>, RhsBoundary>;
+        const auto& lhs_intervals = detail::IntervalUnionAccess::intervals(lhs);
+        return detail::subtract_operands<Result, RhsBoundary>(lhs_intervals, lhs.isnan(), rhs, rhs.isnan(), typename Result::allocator_type(lhs.get_allocator()));
+    }
+
+    template<BoundaryConcept Boundary, std::size_t N>
+    struct FrozenIntervalUnion {
+        // A union of N intervals held in arrays laid out as in an IntervalUnion, built by freeze at
+        // compile time so that it can live in a constexpr variable, which an IntervalUnion cannot as
+        // it allocates. Queried and combined through view().
+
+        using boundary_type = Boundary;
+
+        std::array<Boundary, N> left_values{};
+        std::array<Boundary, N> right_values{};
+        std::array<std::uint64_t, (N + 63)/64> left_closed{};
+        std::array<std::uint64_t, (N + 63)/64> right_closed{};
+        bool nan = false;
+
+        constexpr IntervalUnionView<Boundary> view(void) const {
+            if (nan) { return IntervalUnionView<Boundary>::nan(); }
+            return IntervalUnionView<Boundary>(left_values, right_values, left_closed, right_closed);
+        }
+
+        constexpr std::size_t size(void) const { return N; }
+
+        constexpr bool isnan(void) const { return nan; }
+
+        template<BoundaryConcept BoundaryX>
+        constexpr Boundary operator()(const BoundaryX& x) const { return view()(x); }
+
+        constexpr explicit operator IntervalUnion<Boundary>() const {
+            if (nan) { return IntervalUnion<Boundary>::nan(); }
+            IntervalUnion<Boundary> A;
+            auto& intervals = detail::IntervalUnionAccess::intervals(A);
+            intervals.reserve(N);
+            for (std::size_t i = 0; i != N; ++i) {
+                intervals.push_back(left_values[i], (left_closed[i / 64] >> (i % 64)) & 1, right_values[i], (right_closed[i / 64] >> (i % 64)) & 1);
+            }
+            return A;
+        }
+    };
+
+    template<auto make>
+    consteval auto freeze(void) {
+        // The union returned by make(), a constexpr callable such as a captureless lambda, copied into
+        // a FrozenIntervalUnion. The union itself is built and freed during constant evaluation:
+        //
+        //     constexpr auto A = libp::freeze<[]{ return libp::IntervalUnion{...} || ...; }>();
+        using Union = decltype(make());
+        using Boundary = typename Union::boundary_type;
+        constexpr std::size_t n = [](const Union& A) { return A.isnan() ? 0 : detail::IntervalUnionAccess::intervals(A).size(); }(make());
+        FrozenIntervalUnion<Boundary, n> F;
+        const Union A = make();
+        F.nan = A.isnan();
+        if (!F.nan) {
+            const auto& intervals = detail::IntervalUnionAccess::intervals(A);
+            for (std::size_t i = 0; i != n; ++i) {
+                F.left_values[i] = intervals.left_value(i);
+                F.right_values[i] = intervals.right_value(i);
+                F.left_closed[i / 64] |= std::uint64_t(intervals.left_closed(i)) << (i % 64);
+                F.right_closed[i / 64] |= std::uint64_t(intervals.right_closed(i)) << (i % 64);
+            }
+        }
+        return F;
+    }
+
+    template<BinaryBoundaryConcept Boundary>
+    BinaryReadResult view_binary(const std::byte* first, const std::byte* last, IntervalUnionView<Boundary>& V, bool trusted = false) {
+        // Points V at a union written by write_binary, in place and without copying, so the bytes must
+        // outlive V. Besides the errors of read_binary, reports std::errc::not_supported when the file
+        // cannot be viewed as it stands: its boundary type is not Boundary, the machine is not
+        // little-endian, or first is not 8-byte aligned. Unless trusted is set, the union is checked to
+        // be canonical in one pass, and std::errc::invalid_argument is reported if it is not, since a
+        // view cannot repair it as read_binary does.
+        detail::BinaryHeader header;
+        if (auto ec = detail::read_binary_header(first, last, header); ec != std::errc()) { return {first, ec}; }
+        if (
+            header.boundary_size != sizeof(Boundary) ||
+            std::endian::native != std::endian::little ||
+            reinterpret_cast<std::uintptr_t>(first) % alignof(std::uint64_t) != 0
+        ) {
+            return {first, std::errc::not_supported};
+        }
+        if (header.nan) {
+            V = IntervalUnionView<Boundary>::nan();
+            return {header.end, std::errc()};
+        }
+
+        // The header is 16 bytes and every array a multiple of 8, so each array is aligned for its type.
+        std::size_t n = header.n;
+        const auto* left_values = reinterpret_cast<const Boundary*>(first + detail::binary_header_size);
+        const auto* right_values = left_values + n;
+        const auto* left_closed = reinterpret_cast<const std::uint64_t*>(right_values + n);
+        const auto* right_closed = left_closed + header.words;
+        IntervalUnionView<Boundary> W(
+            {left_values, n},
+            {right_values, n},
+            {left_closed, header.words},
+            {right_closed, header.words}
+        );
+
+        if (!trusted) {
+            for (std::size_t i = 0; i != n; ++i) {
+                const auto& l = W.left_value(i);
+                const auto& r = W.right_value(i);
+                bool lc = W.left_closed(i);
+                bool rc = W.right_closed(i);
+                if (
+                    std::isnan(l) || std::isnan(r) ||
+                    !(l < r || (l == r && lc && rc)) ||
+                    (i != 0 && detail::touches(W.right_value(i-1), W.right_closed(i-1), l, lc))
+                ) {
+                    return {first, std::errc::invalid_argument};
+                }
+            }
+        }
+        V = W;
+        return {header.end, std::errc()};
+    }
+
+    #ifdef LIBP_HAS_MMAP
+
+        class MappedFile {
+            // A whole file mapped read-only into memory, for view_binary. The mapping is page-aligned
+            // and lasts until the MappedFile is destroyed. Throws std::system_error if the file cannot
+            // be opened or mapped.
+
+            public:
+                MappedFile() = default;
+
+                explicit MappedFile(const std::filesystem::path& path) {
+                    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+                    if (fd == -1) { throw std::system_error(errno, std::generic_category(), path.string()); }
+                    struct stat status;
+                    if (::fstat(fd, &status) == -1) {
+                        int error = errno;
+                        ::close(fd);
+                        throw std::system_error(error, std::generic_category(), path.string());
+                    }
+                    size_m = static_cast<std::size_t>(status.st_size);
+                    if (size_m != 0) {
+                        void* mapping = ::mmap(nullptr, size_m, PROT_READ, MAP_PRIVATE, fd, 0);
+                        int error = errno;
+                        ::close(fd);
+                        if (mapping == MAP_FAILED) { throw std::system_error(error, std::generic_category(), path.string()); }
+                        data_m = static_cast<const std::byte*>(mapping);
+                    } else {
+                        ::close(fd);
+                    }
+                }
+
+                MappedFile(MappedFile&& rhs) noexcept:
+                    data_m(std::exchange(rhs.data_m, nullptr)),
+                    size_m(std::exchange(rhs.size_m, 0))
+                { }
+
+                MappedFile& operator=(MappedFile&& rhs) noexcept {
+                    if (this != &rhs) {
+                        unmap();
+                        data_m = std::exchange(rhs.data_m, nullptr);
+                        size_m = std::exchange(rhs.size_m, 0);
+                    }
+                    return *this;
+                }
+
+                MappedFile(const MappedFile&) = delete;
+                MappedFile& operator=(const MappedFile&) = delete;
+
+                ~MappedFile() { unmap(); }
+
+                const std::byte* data(void) const { return data_m; }
+                std::size_t size(void) const { return size_m; }
+                std::span<const std::byte> bytes(void) const { return {data_m, size_m}; }
+
+            private:
+                const std::byte* data_m = nullptr;
+                std::size_t size_m = 0;
+
+                void unmap(void) {
+                    if (data_m != nullptr) { ::munmap(const_cast<std::byte*>(data_m), size_m); }
+                }
+        };
+
+    #endif
+
+}
+
+#endif
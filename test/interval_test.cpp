@@ -1,6 +1,7 @@
 #define BOOST_TEST_DYN_LINK
 
 #include <algorithm>
+#include <bit>
 #include <chrono>
 #include <cmath>
 #include <cstring>
@@ -8,14 +9,30 @@
 #include <filesystem>
 #include <fstream>
 #include <limits>
+#include <memory>
+#include <memory_resource>
+#include <numeric>
 #include <random>
+#include <span>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <vector>
 #include <boost/test/unit_test.hpp>
 #include <stan/math.hpp>
 #include <libp/sets/interval.hpp>
+#include <libp/sets/interval_binary.hpp>
+#include <libp/sets/interval_charconv.hpp>
+#include <libp/sets/interval_expression.hpp>
+#include <libp/sets/interval_overlay.hpp>
+#include <libp/sets/interval_parallel.hpp>
+#include <libp/sets/interval_sampler.hpp>
+#include <libp/sets/interval_set.hpp>
+#include <libp/sets/interval_static.hpp>
+#include <libp/sets/interval_stream.hpp>
+#include <libp/sets/interval_var.hpp>
+#include <libp/sets/interval_view.hpp>
 
 BOOST_AUTO_TEST_CASE(simple_interval_test) {
     BOOST_TEST(libp::Interval('(',1.0,-1.0,')') == libp::Interval('(',0.0,0.0,')'));
@@ -34,6 +51,16 @@ BOOST_AUTO_TEST_CASE(simple_interval_test) {
     BOOST_TEST(C == D);
 }
 
+BOOST_AUTO_TEST_CASE(interval_union_iteration_test) {
+    libp::IntervalUnion<double> A = {{'[',3.0,4.0,')'}, {'(',-1.0,0.0,']'}, {'[',0.0,1.0,')'}, {'(',5.0,5.0,']'}, {'[',7.0,7.0,']'}};
+    std::vector<libp::Interval<double>> expected = {{'(',-1.0,1.0,')'}, {'[',3.0,4.0,')'}, {'[',7.0,7.0,']'}};
+    BOOST_TEST(std::distance(A.cbegin(), A.cend()) == 3);
+    BOOST_TEST(std::equal(A.cbegin(), A.cend(), expected.cbegin(), expected.cend()));
+    BOOST_TEST((A.cbegin() + 1)->left_bracket() == '[');
+    BOOST_TEST(A.cbegin()[2].issingleton());
+    BOOST_TEST(libp::IntervalUnion<double>(A.cbegin(), A.cend()) == A);
+}
+
 template<libp::BoundaryConcept B>
 bool complex_interval_test_impl(int n);
 
@@ -327,11 +354,27 @@ bool complex_interval_test_impl_fixed_boundary_types(int n) {
         const auto infB = std::numeric_limits<typename std::decay_t<decltype(B)>::boundary_type>::infinity();
         auto AorB = A || B;
         auto AandB = A && B;
+        auto AminusB = A - B;
         bool pass;
         bool pass_all = true;
+        if constexpr (requires (std::decay_t<decltype(A)> X) { X |= B; X &= B; X -= B; }) {
+            auto A_or_equals_B = A; A_or_equals_B |= B;
+            auto A_and_equals_B = A; A_and_equals_B &= B;
+            auto A_minus_equals_B = A; A_minus_equals_B -= B;
+            if (A.isnan() || B.isnan()) {
+                BOOST_TEST(pass = A_or_equals_B.isnan()); pass_all = pass_all && pass;
+                BOOST_TEST(pass = A_and_equals_B.isnan()); pass_all = pass_all && pass;
+                BOOST_TEST(pass = A_minus_equals_B.isnan()); pass_all = pass_all && pass;
+            } else {
+                BOOST_TEST(pass = A_or_equals_B == std::decay_t<decltype(A)>(AorB)); pass_all = pass_all && pass;
+                BOOST_TEST(pass = A_and_equals_B == std::decay_t<decltype(A)>(AandB)); pass_all = pass_all && pass;
+                BOOST_TEST(pass = A_minus_equals_B == std::decay_t<decltype(A)>(AminusB)); pass_all = pass_all && pass;
+            }
+        }
         if (A.isnan() || B.isnan()) {
             BOOST_TEST(pass = AorB.isnan()); pass_all = pass_all && pass;
             BOOST_TEST(pass = AandB.isnan()); pass_all = pass_all && pass;
+            BOOST_TEST(pass = AminusB.isnan()); pass_all = pass_all && pass;
         } else {
             BOOST_TEST(pass = AorB == (B||A)); pass_all = pass_all && pass;
             BOOST_TEST(pass = AandB == (B&&A)); pass_all = pass_all && pass;
@@ -513,3 +556,1151 @@ bool complex_interval_test_impl(int n) {
     pass = pass && complex_interval_test_impl<BB, BC, BD, Tail...>(n);
     return pass;
 }
+
+template<std::floating_point B>
+libp::IntervalUnion<B> draw_large_interval_union(std::default_random_engine& eng, int interval_count) {
+    std::uniform_real_distribution<B> boundary_dist(-1000, 1000);
+    std::bernoulli_distribution repeat_dist(0.1);
+    std::bernoulli_distribution closed_bracket_dist(0.5);
+    std::vector<B> boundaries(2*interval_count);
+    for (auto& b : boundaries) { b = boundary_dist(eng); }
+    std::sort(boundaries.begin(), boundaries.end());
+    for (std::size_t i = 1; i < boundaries.size(); ++i) {
+        if (repeat_dist(eng)) { boundaries[i] = boundaries[i-1]; }
+    }
+    std::vector<libp::Interval<B>> intervals;
+    for (std::size_t i = 0; i + 1 < boundaries.size(); i += 2) {
+        intervals.emplace_back(
+            closed_bracket_dist(eng) ? '[' : '(',
+            boundaries[i],
+            boundaries[i+1],
+            closed_bracket_dist(eng) ? ']' : ')'
+        );
+    }
+    return libp::IntervalUnion<B>(intervals.begin(), intervals.end());
+}
+
+template<std::floating_point B>
+std::vector<B> draw_query_points(std::default_random_engine& eng, const libp::IntervalUnion<B>& A, int random_count) {
+    // Every boundary, its neighbouring representable values, the infinities, NaN, and some uniform draws.
+    const auto inf = std::numeric_limits<B>::infinity();
+    std::vector<B> xs = {-inf, inf, std::numeric_limits<B>::quiet_NaN(), 0, -0.0};
+    for (auto iter = A.cbegin(); iter != A.cend(); ++iter) {
+        for (auto x : {iter->left_value(), iter->right_value()}) {
+            xs.push_back(x);
+            xs.push_back(std::nextafter(x, -inf));
+            xs.push_back(std::nextafter(x, inf));
+        }
+    }
+    std::uniform_real_distribution<B> x_dist(-1100, 1100);
+    for (int i = 0; i != random_count; ++i) { xs.push_back(x_dist(eng)); }
+    std::shuffle(xs.begin(), xs.end(), eng);
+    return xs;
+}
+
+template<std::floating_point B>
+bool batch_contains_test_impl(std::default_random_engine& eng, int interval_count) {
+    auto A = draw_large_interval_union<B>(eng, interval_count);
+    auto xs = draw_query_points(eng, A, 1000);
+
+    std::vector<B> left_values, right_values;
+    std::vector<std::uint64_t> left_closed((interval_count + 63)/64), right_closed((interval_count + 63)/64);
+    for (auto iter = A.cbegin(); iter != A.cend(); ++iter) {
+        auto i = left_values.size();
+        left_values.push_back(iter->left_value());
+        right_values.push_back(iter->right_value());
+        left_closed[i/64] |= std::uint64_t(iter->left_bracket() == '[') << (i%64);
+        right_closed[i/64] |= std::uint64_t(iter->right_bracket() == ']') << (i%64);
+    }
+    libp::detail::IntervalArrays<B> arrays{left_values.data(), right_values.data(), left_closed.data(), right_closed.data(), left_values.size()};
+
+    bool pass = true;
+    std::vector<std::uint64_t> bits((xs.size() + 63)/64);
+    std::unique_ptr<bool[]> mask(new bool[xs.size()]);
+    std::unique_ptr<bool[]> public_mask(new bool[xs.size()]);
+    A.contains(xs, std::span<bool>(public_mask.get(), xs.size()));
+    for (auto level : {libp::detail::SimdLevel::scalar, libp::detail::SimdLevel::avx2, libp::detail::SimdLevel::avx512}) {
+        if (level > libp::detail::supported_simd_level()) { continue; }
+        libp::detail::contains(arrays, xs.data(), xs.size(), mask.get(), level);
+        libp::detail::contains(arrays, xs.data(), xs.size(), bits.data(), level);
+        for (std::size_t k = 0; k != xs.size(); ++k) {
+            bool expected = A(xs[k]);
+            BOOST_TEST(mask[k] == expected); pass = pass && mask[k] == expected;
+            BOOST_TEST(((bits[k/64] >> (k%64)) & 1) == expected); pass = pass && ((bits[k/64] >> (k%64)) & 1) == expected;
+            BOOST_TEST(public_mask[k] == expected); pass = pass && public_mask[k] == expected;
+        }
+    }
+    return pass;
+}
+
+BOOST_AUTO_TEST_CASE(batch_contains_test) {
+    std::default_random_engine eng{std::random_device{}()};
+    for (int interval_count : {0, 1, 2, 3, 7, 64, 65, 1000}) {
+        if (!batch_contains_test_impl<double>(eng, interval_count)) { break; }
+        if (!batch_contains_test_impl<float>(eng, interval_count)) { break; }
+    }
+
+    libp::IntervalUnion<double> A = {{'[',0.0,1.0,')'}, {'(',2.0,3.0,']'}};
+    std::vector<float> xs = {0, 0.5, 1, 2, 2.5, 3, 4};
+    std::vector<std::uint64_t> bits(1);
+    A.contains(std::span<const float>(xs), std::span<std::uint64_t>(bits));
+    BOOST_TEST(bits[0] == 0b0110011u);
+}
+
+BOOST_AUTO_TEST_CASE(classify_sorted_test) {
+    std::default_random_engine eng{std::random_device{}()};
+    for (int interval_count : {0, 1, 2, 5, 100, 1000}) {
+        auto A = draw_large_interval_union<double>(eng, interval_count);
+        auto xs = draw_query_points(eng, A, interval_count);
+        std::erase_if(xs, [](double x) { return std::isnan(x); });
+        std::sort(xs.begin(), xs.end());
+
+        std::vector<std::size_t> indices;
+        A.classify_sorted(xs, std::back_inserter(indices));
+        BOOST_TEST(indices.size() == xs.size());
+        for (std::size_t k = 0; k != xs.size(); ++k) {
+            if (indices[k] == A.gap) {
+                BOOST_TEST(!A(xs[k]));
+            } else {
+                BOOST_TEST(A.cbegin()[indices[k]](xs[k]));
+            }
+        }
+
+        // A sparse subsequence of the finite points, read through an input iterator so that nothing is
+        // buffered.
+        std::stringstream ss;
+        ss.precision(std::numeric_limits<double>::max_digits10);
+        std::vector<std::size_t> expected_sparse_indices;
+        for (std::size_t k = 1; k + 1 < xs.size(); k += 17) {
+            ss << xs[k] << ' ';
+            expected_sparse_indices.push_back(indices[k]);
+        }
+        std::vector<std::size_t> sparse_indices;
+        A.classify_sorted(std::istream_iterator<double>(ss), std::istream_iterator<double>(), std::back_inserter(sparse_indices));
+        BOOST_TEST(sparse_indices == expected_sparse_indices);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(search_index_test) {
+    std::default_random_engine eng{std::random_device{}()};
+    for (int interval_count : {1, 2, 3, 4, 7, 8, 9, 15, 16, 17, 100, 1000, 20000}) {
+        auto A = draw_large_interval_union<double>(eng, interval_count);
+        auto B = A;
+        A.build_search_index();
+        auto xs = draw_query_points(eng, A, 1000);
+        bool pass = true;
+        for (auto x : xs) {
+            BOOST_TEST(A(x) == B(x)); pass = pass && A(x) == B(x);
+            if (!pass) { break; }
+        }
+
+        // The unindexed copy builds its own index for large enough batches, the indexed union uses
+        // its index for any batch, and a union assigned from another starts without one.
+        std::unique_ptr<bool[]> mask_A(new bool[xs.size()]);
+        std::unique_ptr<bool[]> mask_B(new bool[xs.size()]);
+        A.contains(xs, std::span<bool>(mask_A.get(), xs.size()));
+        B.contains(xs, std::span<bool>(mask_B.get(), xs.size()));
+        BOOST_TEST(std::equal(mask_A.get(), mask_A.get() + xs.size(), mask_B.get()));
+        auto C = draw_large_interval_union<double>(eng, interval_count);
+        A = C;
+        for (auto x : xs) {
+            BOOST_TEST(A(x) == C(x)); pass = pass && A(x) == C(x);
+            if (!pass) { break; }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(compound_assignment_test) {
+    libp::IntervalUnion<double> A = {{'[',0.0,1.0,')'}, {'(',2.0,3.0,']'}};
+    auto B = A; B |= B; BOOST_TEST(B == A);
+    auto C = A; C &= C; BOOST_TEST(C == A);
+    auto D = A; D -= D; BOOST_TEST(D.isempty());
+
+    // Accumulating into one union gives the same result as building a new union at every step.
+    std::default_random_engine eng{std::random_device{}()};
+    libp::IntervalUnion<double> acc_or, acc_and = libp::IntervalUnion<double>::universal(true), acc_minus = libp::IntervalUnion<double>::universal();
+    libp::IntervalUnion<double> expected_or, expected_and = acc_and, expected_minus = acc_minus;
+    for (int i = 0; i != 50; ++i) {
+        auto E = draw_large_interval_union<double>(eng, 20);
+        acc_or |= E; expected_or = expected_or || E;
+        acc_and &= E.inv(i % 2); expected_and = expected_and && E.inv(i % 2);
+        acc_minus -= E; expected_minus = expected_minus - E;
+        BOOST_TEST(acc_or == expected_or);
+        BOOST_TEST(acc_and == expected_and);
+        BOOST_TEST(acc_minus == expected_minus);
+    }
+}
+
+std::vector<libp::IntervalUnion<double>> draw_small_interval_unions(std::default_random_engine& eng, int union_count) {
+    // Small unions whose boundaries often coincide, so that every pairing of brackets at a shared value
+    // is exercised.
+    std::uniform_int_distribution<int> boundary_dist(0, 12);
+    std::uniform_int_distribution<int> interval_count_dist(0, 4);
+    std::bernoulli_distribution closed_bracket_dist(0.5);
+    std::bernoulli_distribution complement_dist(0.3);
+    std::vector<libp::IntervalUnion<double>> unions(union_count);
+    for (auto& A : unions) {
+        std::vector<libp::Interval<double>> intervals;
+        for (int i = interval_count_dist(eng); i != 0; --i) {
+            intervals.emplace_back(
+                closed_bracket_dist(eng) ? '[' : '(', double(boundary_dist(eng)), double(boundary_dist(eng)), closed_bracket_dist(eng) ? ']' : ')'
+            );
+        }
+        A = libp::IntervalUnion<double>(intervals.begin(), intervals.end());
+        if (complement_dist(eng)) { A = A.inv(closed_bracket_dist(eng)); }
+    }
+    return unions;
+}
+
+BOOST_AUTO_TEST_CASE(union_all_intersect_all_test) {
+    // Compared against folds of the binary operators.
+    std::default_random_engine eng{std::random_device{}()};
+    for (int trial = 0; trial != 200; ++trial) {
+        auto unions = draw_small_interval_unions(eng, trial % 9);
+        auto expected_union = libp::IntervalUnion<double>::empty();
+        auto expected_intersection = libp::IntervalUnion<double>::universal(true);
+        for (const auto& A : unions) {
+            expected_union = expected_union || A;
+            expected_intersection = expected_intersection && A;
+        }
+        BOOST_TEST(libp::union_all(unions) == expected_union);
+        BOOST_TEST(libp::intersect_all(unions) == expected_intersection);
+    }
+
+    std::vector<libp::IntervalUnion<double>> unions = {{{'[',0.0,1.0,')'}}, libp::IntervalUnion<double>::nan(), {}};
+    BOOST_TEST(libp::union_all(unions).isnan());
+    BOOST_TEST(libp::intersect_all(unions).isnan());
+    unions.erase(unions.begin() + 1);
+    BOOST_TEST(libp::union_all(unions) == unions[0]);
+    BOOST_TEST(libp::intersect_all(unions).isempty());
+}
+
+BOOST_AUTO_TEST_CASE(overlay_test) {
+    std::default_random_engine eng{std::random_device{}()};
+    auto point_in = [](const libp::Interval<double>& I) {
+        if (I.issingleton()) { return I.left_value(); }
+        if (std::isinf(I.left_value()) && std::isinf(I.right_value())) { return 0.0; }
+        if (std::isinf(I.left_value())) { return I.right_value() - 1; }
+        if (std::isinf(I.right_value())) { return I.left_value() + 1; }
+        return (I.left_value() + I.right_value())/2;
+    };
+    for (int trial = 0; trial != 200; ++trial) {
+        auto unions = draw_small_interval_unions(eng, trial % 6);
+        auto covered = libp::union_all(unions);
+
+        // The segments are in order, cover exactly the union of the inputs, and are labelled with the
+        // inputs containing them.
+        std::vector<libp::Interval<double>> count_segments, member_segments;
+        libp::overlay_counts(unions, [&](const libp::Interval<double>& I, std::size_t count) {
+            std::size_t expected_count = 0;
+            for (const auto& A : unions) { expected_count += A(point_in(I)); }
+            BOOST_TEST(count == expected_count);
+            count_segments.push_back(I);
+        });
+        libp::overlay_members(unions, [&](const libp::Interval<double>& I, std::span<const std::uint64_t> members) {
+            for (std::size_t k = 0; k != unions.size(); ++k) {
+                BOOST_TEST(bool((members[k/64] >> (k%64)) & 1) == bool(unions[k](point_in(I))));
+            }
+            member_segments.push_back(I);
+        });
+        BOOST_TEST(libp::IntervalUnion<double>(count_segments.begin(), count_segments.end()) == covered);
+        BOOST_TEST(libp::IntervalUnion<double>(member_segments.begin(), member_segments.end()) == covered);
+        BOOST_TEST(std::is_sorted(member_segments.begin(), member_segments.end(), [](const auto& I, const auto& J) {
+            return I.left_value() < J.left_value();
+        }));
+
+        // At least k of n is the union, over every choice of k inputs, of their intersection.
+        for (std::size_t k = 0; k <= unions.size() + 1; ++k) {
+            auto expected = k == 0 ? libp::IntervalUnion<double>::universal(true) : libp::IntervalUnion<double>::empty();
+            for (unsigned subset = 0; k != 0 && subset != (1u << unions.size()); ++subset) {
+                if (std::size_t(std::popcount(subset)) == k) {
+                    auto intersection = libp::IntervalUnion<double>::universal(true);
+                    for (std::size_t j = 0; j != unions.size(); ++j) {
+                        if ((subset >> j) & 1) { intersection = intersection && unions[j]; }
+                    }
+                    expected = expected || intersection;
+                }
+            }
+            BOOST_TEST(libp::at_least_k(unions, k) == expected);
+        }
+    }
+
+    std::vector<libp::IntervalUnion<double>> unions = {{{'[',0.0,1.0,')'}}, {{'[',1.0,2.0,']'}}, {{'(',0.0,1.0,']'}}};
+    std::vector<std::size_t> counts;
+    BOOST_TEST(libp::overlay_counts(unions, [&](const libp::Interval<double>&, std::size_t count) { counts.push_back(count); }));
+    BOOST_TEST((counts == std::vector<std::size_t>{1, 2, 1}));
+    BOOST_TEST((libp::at_least_k(unions, 2) == libp::IntervalUnion<double>{{'(',0.0,1.0,']'}}));
+    unions.push_back(libp::IntervalUnion<double>::nan());
+    BOOST_TEST(!libp::overlay_counts(unions, [](const libp::Interval<double>&, std::size_t) { }));
+    BOOST_TEST(libp::at_least_k(unions, 1).isnan());
+}
+
+BOOST_AUTO_TEST_CASE(lazy_expression_test) {
+    // Compared against the eager operators, which the expressions must match bracket for bracket.
+    std::default_random_engine eng{std::random_device{}()};
+    for (int trial = 0; trial != 200; ++trial) {
+        auto unions = draw_small_interval_unions(eng, 3);
+        const auto& A = unions[0];
+        const auto& B = unions[1];
+        const auto& C = unions[2];
+        bool extended = trial % 2;
+        libp::IntervalUnion<double> D = (libp::lazy(A) && !libp::lazy(B)) || libp::lazy(C);
+        BOOST_TEST(D == ((A && !B) || C));
+        BOOST_TEST((libp::lazy(A) - B).eval() == A - B);
+        BOOST_TEST((A - libp::lazy(B) - C).eval() == (A - B) - C);
+        BOOST_TEST((!(libp::lazy(A) || B)).eval() == !(A || B));
+        BOOST_TEST((libp::lazy(A).inv(extended) && libp::lazy(B).inv(!extended)).eval() == (A.inv(extended) && B.inv(!extended)));
+        BOOST_TEST((!!libp::lazy(C) || !(libp::lazy(A) && C)).eval() == (!!C || !(A && C)));
+        D = libp::lazy(D) && A;
+        BOOST_TEST(D == (((A && !B) || C) && A));
+    }
+
+    libp::IntervalUnion<double> A = {{'[',0.0,2.0,')'}, {'(',3.0,4.0,']'}};
+    libp::IntervalUnion<float> B = {{'(',1.0f,3.0f,']'}};
+    auto AB = (libp::lazy(A) || B).eval();
+    BOOST_TEST((std::is_same_v<decltype(AB), libp::IntervalUnion<double>>));
+    BOOST_TEST((AB == libp::IntervalUnion<double>{{'[',0.0,4.0,']'}}));
+    libp::IntervalUnion<float> BA = libp::lazy(B) - A;
+    BOOST_TEST((BA == libp::IntervalUnion<float>{{'[',2.0f,3.0f,']'}}));
+    BOOST_TEST((libp::lazy(A) && libp::IntervalUnion<double>::nan()).eval().isnan());
+}
+
+BOOST_AUTO_TEST_CASE(set_predicate_test) {
+    // Compared against the definitions through the set operators.
+    std::default_random_engine eng{std::random_device{}()};
+    for (int trial = 0; trial != 500; ++trial) {
+        auto unions = draw_small_interval_unions(eng, 2);
+        const auto& A = unions[0];
+        auto B = trial % 3 == 0 ? A || unions[1] : trial % 3 == 1 ? A && unions[1] : unions[1];
+        BOOST_TEST((A <= B) == (A - B).isempty());
+        BOOST_TEST((A >= B) == (B - A).isempty());
+        BOOST_TEST((A < B) == ((A - B).isempty() && !(B - A).isempty()));
+        BOOST_TEST((A > B) == ((B - A).isempty() && !(A - B).isempty()));
+        BOOST_TEST(isdisjoint(A, B) == (A && B).isempty());
+        BOOST_TEST(overlaps(A, B) == !(A && B).isempty());
+        BOOST_TEST(isdisjoint(A, B) == isdisjoint(libp::IntervalUnion<float>(B), A));
+        BOOST_TEST((A <= B) == (A <= libp::IntervalUnion<float>(B)));
+    }
+
+    libp::IntervalUnion<double> A = {{'[',0.0,1.0,')'}, {'(',1.0,2.0,']'}};
+    libp::IntervalUnion<double> B = {{'[',0.0,2.0,']'}};
+    BOOST_TEST((A < B));
+    BOOST_TEST(!(B <= A));
+    BOOST_TEST(isdisjoint(A, libp::IntervalUnion<double>{{'[',1.0,1.0,']'}}));
+    BOOST_TEST(overlaps(A, libp::IntervalUnion<double>{{'[',2.0,3.0,']'}}));
+    BOOST_TEST(!isdisjoint(A, libp::IntervalUnion<double>{{'[',2.0,3.0,']'}}));
+    auto nan = libp::IntervalUnion<double>::nan();
+    BOOST_TEST(!(nan <= B)); BOOST_TEST(!(B <= nan)); BOOST_TEST(!(nan < B)); BOOST_TEST(!(B >= nan));
+    BOOST_TEST(!isdisjoint(nan, B)); BOOST_TEST(!overlaps(nan, B));
+}
+
+template<std::size_t N>
+void inline_storage_test_impl(std::default_random_engine& eng) {
+    for (int interval_count : {0, 1, 2, 3, 8, 100}) {
+        auto A = draw_large_interval_union<double>(eng, interval_count);
+        auto B = draw_large_interval_union<double>(eng, interval_count/2 + 1);
+        libp::IntervalUnion<double, N> An(A.cbegin(), A.cend());
+        libp::IntervalUnion<double, N> Bn(B.cbegin(), B.cend());
+        BOOST_TEST(An == A);
+
+        // Copies, moves and swaps between inline and heap storage.
+        auto C = An; BOOST_TEST(C == A);
+        auto D = std::move(C); BOOST_TEST(D == A); BOOST_TEST(C.isempty());
+        C = Bn; BOOST_TEST(C == B);
+        C = std::move(D); BOOST_TEST(C == A);
+        D = C; D = D; BOOST_TEST(D == A);
+        swap(C, Bn); BOOST_TEST(C == B); BOOST_TEST(Bn == A);
+        swap(C, Bn);
+
+        // Operators mixing inline capacities keep the capacity of the left operand.
+        auto E = An && B;
+        BOOST_TEST((std::is_same_v<decltype(E), libp::IntervalUnion<double, N>>));
+        BOOST_TEST(E == (A && B));
+        BOOST_TEST((B || An) == (B || A));
+        BOOST_TEST((An - B) == (A - B));
+        BOOST_TEST((An <= (A || B)));
+        An |= B; BOOST_TEST(An == (A || B));
+        An -= B; BOOST_TEST(An == (A - B));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(inline_storage_test) {
+    std::default_random_engine eng{std::random_device{}()};
+    inline_storage_test_impl<0>(eng);
+    inline_storage_test_impl<1>(eng);
+    inline_storage_test_impl<2>(eng);
+    inline_storage_test_impl<8>(eng);
+}
+
+BOOST_AUTO_TEST_CASE(allocator_test) {
+    std::default_random_engine eng{std::random_device{}()};
+    std::vector<std::byte> buffer(1 << 20);
+    std::pmr::monotonic_buffer_resource resource(buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+    auto from_resource = [&](const auto& A) { return A.get_allocator().resource() == &resource; };
+
+    for (int interval_count : {0, 1, 3, 50}) {
+        auto A = draw_large_interval_union<double>(eng, interval_count);
+        auto B = draw_large_interval_union<double>(eng, interval_count/2 + 1);
+        libp::pmr::IntervalUnion<double> Ap(A, &resource);
+        libp::pmr::IntervalUnion<double> Bp(B.cbegin(), B.cend(), &resource);
+        BOOST_TEST(Ap == A); BOOST_TEST(from_resource(Ap));
+        BOOST_TEST(Bp == B); BOOST_TEST(from_resource(Bp));
+
+        // Results allocate from the left operand, rebound to the common boundary type.
+        auto C = Ap && B; BOOST_TEST(C == (A && B)); BOOST_TEST(from_resource(C));
+        auto D = Ap || B; BOOST_TEST(D == (A || B)); BOOST_TEST(from_resource(D));
+        auto E = Ap - Bp; BOOST_TEST(E == (A - B)); BOOST_TEST(from_resource(E));
+        auto F = Ap && libp::IntervalUnion<long double>(B);
+        BOOST_TEST((std::is_same_v<decltype(F), libp::pmr::IntervalUnion<long double>>));
+        BOOST_TEST(from_resource(F));
+        BOOST_TEST(from_resource(Ap.inv()));
+        BOOST_TEST(from_resource(libp::lazy(Ap).eval(Ap.get_allocator())));
+        std::pmr::vector<libp::pmr::IntervalUnion<double>> unions({Ap, Bp}, &resource);
+        BOOST_TEST(from_resource(libp::union_all(unions)));
+        BOOST_TEST(from_resource(libp::intersect_all(unions)));
+        BOOST_TEST(from_resource(libp::at_least_k(unions, 1)));
+
+        // Compound assignment keeps the allocator of the target; copies ask the allocator.
+        Ap |= B; BOOST_TEST(Ap == (A || B)); BOOST_TEST(from_resource(Ap));
+        auto G = Ap; BOOST_TEST(G == Ap); BOOST_TEST(!from_resource(G));
+        libp::pmr::IntervalUnion<double> H(&resource); H = Ap; BOOST_TEST(from_resource(H));
+        BOOST_TEST(from_resource(libp::pmr::IntervalUnion<double>::nan(&resource)));
+
+        // Moving between unequal resources copies into the target's storage, which may throw.
+        std::pmr::monotonic_buffer_resource other;
+        libp::pmr::IntervalUnion<double> I(A, &other), J(&resource);
+        J = std::move(I); BOOST_TEST(J == A); BOOST_TEST(from_resource(J));
+        libp::pmr::IntervalUnion<double> K(&other);
+        K = std::move(J); BOOST_TEST(K == A); BOOST_TEST(K.get_allocator().resource() == &other);
+    }
+    static_assert(std::is_nothrow_move_assignable_v<libp::IntervalUnion<double>>);
+    static_assert(!std::is_nothrow_move_assignable_v<libp::pmr::IntervalUnion<double>>);
+    libp::pmr::IntervalUnion<double> full(draw_large_interval_union<double>(eng, 100), &resource);
+    libp::pmr::IntervalUnion<double> nowhere(std::pmr::null_memory_resource());
+    BOOST_CHECK_THROW(nowhere = std::move(full), std::bad_alloc);
+}
+
+BOOST_AUTO_TEST_CASE(parallel_test) {
+    // Small thresholds split even small operands into several windows, and the boundaries shared
+    // between the operands put cuts on every kind of bracket.
+    std::default_random_engine eng{std::random_device{}()};
+    for (int trial = 0; trial != 200; ++trial) {
+        libp::ParallelOptions options{unsigned(1 + trial % 5), std::size_t(1 + trial % 3)};
+        auto small = draw_small_interval_unions(eng, 2);
+        for (const auto& [A, B] : {
+            std::pair(small[0], small[1]),
+            std::pair(draw_large_interval_union<double>(eng, trial), draw_large_interval_union<double>(eng, trial/2))
+        }) {
+            BOOST_TEST(libp::parallel_intersection(A, B, options) == (A && B));
+            BOOST_TEST(libp::parallel_union(A, B, options) == (A || B));
+            BOOST_TEST(libp::parallel_union(B, A, options) == (B || A));
+            BOOST_TEST(libp::parallel_inv(A, false, options) == A.inv(false));
+            BOOST_TEST(libp::parallel_inv(A, true, options) == A.inv(true));
+            libp::IntervalUnion<float> Af(A);
+            auto C = libp::parallel_intersection(Af, B, options);
+            BOOST_TEST((std::is_same_v<decltype(C), libp::IntervalUnion<double>>));
+            BOOST_TEST(C == (Af && B));
+        }
+    }
+
+    auto nan = libp::IntervalUnion<double>::nan();
+    libp::IntervalUnion<double> A{{'[',0.0,1.0,']'}, {'[',2.0,3.0,']'}};
+    libp::ParallelOptions options{4, 1};
+    BOOST_TEST(libp::parallel_intersection(A, nan, options).isnan());
+    BOOST_TEST(libp::parallel_union(nan, A, options).isnan());
+    BOOST_TEST(libp::parallel_inv(nan, false, options).isnan());
+}
+
+BOOST_AUTO_TEST_CASE(parallel_construction_test) {
+    // Overlapping and touching intervals on a small grid, compared against the serial constructor.
+    std::default_random_engine eng{std::random_device{}()};
+    std::uniform_int_distribution<int> boundary_dist(0, 40);
+    std::bernoulli_distribution closed_bracket_dist(0.5);
+    for (int trial = 0; trial != 200; ++trial) {
+        libp::ParallelOptions options{unsigned(1 + trial % 5), std::size_t(1 + trial % 3)};
+        std::vector<libp::Interval<double>> intervals;
+        for (int i = 0; i != trial; ++i) {
+            intervals.emplace_back(
+                closed_bracket_dist(eng) ? '[' : '(', double(boundary_dist(eng)), double(boundary_dist(eng)), closed_bracket_dist(eng) ? ']' : ')'
+            );
+        }
+        libp::IntervalUnion<double> expected(intervals.begin(), intervals.end());
+        BOOST_TEST(libp::parallel_interval_union(intervals.begin(), intervals.end(), options) == expected);
+        if (trial != 0) {
+            intervals[trial/2] = libp::Interval<double>::nan();
+            BOOST_TEST(libp::parallel_interval_union(intervals.begin(), intervals.end(), options).isnan());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(from_chars_test) {
+    // Every union in the test cases file parses as operator>> parses it.
+    std::ifstream file{"interval_test_cases.txt"};
+    std::string text{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    std::istringstream stream{text};
+    const char* first = text.data();
+    const char* last = text.data() + text.size();
+    int count = 0;
+    for (libp::IntervalUnion<double> expected; stream >> expected && !stream.eof(); ++count) {
+        libp::IntervalUnion<double> A;
+        auto [end, ec] = libp::from_chars(first, last, A);
+        BOOST_TEST((ec == std::errc()));
+        BOOST_TEST((A == expected || (A.isnan() && expected.isnan())));
+        BOOST_TEST(std::size_t(end - text.data()) == std::size_t(stream.tellg()));
+        first = end;
+    }
+    BOOST_TEST(count > 0);
+
+    // The text is copied to a heap buffer of exactly its size, so that reading past it is caught
+    // by the sanitizers.
+    auto parse = [](std::string_view s, libp::IntervalUnion<double>& A) {
+        std::vector<char> text(s.begin(), s.end());
+        auto [end, ec] = libp::from_chars(text.data(), text.data() + text.size(), A);
+        return ec == std::errc() ? end - text.data() : -1;
+    };
+    libp::IntervalUnion<double> A;
+    BOOST_TEST(parse("(0,0);", A) == 6); BOOST_TEST(A.isempty());
+    BOOST_TEST(parse(" [ 2 , 3 ) \n[-inf,1e0]; [5,6]", A) == 23);
+    BOOST_TEST((A == libp::IntervalUnion<double>{{'[',-INFINITY,1.0,']'}, {'[',2.0,3.0,')'}}));
+    BOOST_TEST(parse("[5,6]", A) == 5); BOOST_TEST((A == libp::IntervalUnion<double>('[',5.0,6.0,']')));
+    BOOST_TEST(parse("(nan,nan][0,1];", A) == 15); BOOST_TEST(A.isnan());
+    BOOST_TEST(parse(";", A) == 1); BOOST_TEST(A.isempty());
+    A = libp::IntervalUnion<double>('[',5.0,6.0,']');
+    for (auto bad : {"", "[1,2", "[1;2];", "{1,2};", "[+inf,1];", "[-nan,1];", "[infinity,1];", "[1,2]x", "[1e400,1];", "[", "[0,", "[0,1"}) {
+        BOOST_TEST(parse(bad, A) == -1);
+    }
+    BOOST_TEST((A == libp::IntervalUnion<double>('[',5.0,6.0,']')));
+
+    libp::Interval<float> I;
+    for (std::string_view truncated : {"[", "[0,", "[0,1", "[ ", "[0 , "}) {
+        std::vector<char> text(truncated.begin(), truncated.end());
+        BOOST_TEST((libp::from_chars(text.data(), text.data() + text.size(), I).ec == std::errc::invalid_argument));
+    }
+    std::string_view s = "(-1.5,+2]";
+    auto [end, ec] = libp::from_chars(s.data(), s.data() + s.size(), I);
+    BOOST_TEST((ec == std::errc())); BOOST_TEST(end == s.data() + s.size());
+    BOOST_TEST((I == libp::Interval<float>('(',-1.5f,2.0f,']')));
+}
+
+BOOST_AUTO_TEST_CASE(to_chars_test) {
+    // Writing and parsing round-trip exactly, and the text matches operator<< at max_digits10 up to
+    // how the boundaries are spelled.
+    std::default_random_engine eng{std::random_device{}()};
+    std::vector<char> buffer(1 << 16);
+    char* first = buffer.data();
+    char* last = buffer.data() + buffer.size();
+    for (int trial = 0; trial != 200; ++trial) {
+        auto A = trial % 2 ? draw_large_interval_union<double>(eng, trial) : draw_small_interval_unions(eng, 1)[0];
+        auto [end, ec] = libp::to_chars(first, last, A);
+        BOOST_TEST((ec == std::errc()));
+        libp::IntervalUnion<double> B;
+        auto [parsed_end, parsed_ec] = libp::from_chars(first, static_cast<const char*>(end), B);
+        BOOST_TEST((parsed_ec == std::errc())); BOOST_TEST(parsed_end == end);
+        BOOST_TEST(B == A);
+        std::string text(first, end);
+        auto [rewritten_end, rewritten_ec] = libp::to_chars(first, last, B);
+        BOOST_TEST(std::string(first, rewritten_end) == text);
+
+        std::ostringstream stream; stream.precision(std::numeric_limits<double>::max_digits10); stream << A;
+        auto streamed = stream.str();
+        libp::IntervalUnion<double> C; std::istringstream(text) >> C;
+        BOOST_TEST(C == A);
+        BOOST_TEST(std::count(text.begin(), text.end(), ',') == std::count(streamed.begin(), streamed.end(), ','));
+
+        auto [short_end, short_ec] = libp::to_chars(first, first + text.size() - 1, A);
+        BOOST_TEST((short_ec == std::errc::value_too_large));
+    }
+
+    auto write = [&](const auto& X) { return std::string(first, libp::to_chars(first, last, X).ptr); };
+    BOOST_TEST(write(libp::IntervalUnion<double>()) == "(0,0);");
+    BOOST_TEST(write(libp::IntervalUnion<double>::nan()) == "(nan,nan];");
+    BOOST_TEST(write(libp::IntervalUnion<double>::universal(true)) == "[-inf,inf];");
+    BOOST_TEST(write(libp::Interval<float>('(', 0.1f, 1e30f, ']')) == "(0.1,1e+30]");
+}
+
+BOOST_AUTO_TEST_CASE(binary_test) {
+    std::default_random_engine eng{std::random_device{}()};
+    std::vector<std::byte> buffer(1 << 16);
+    std::byte* first = buffer.data();
+    std::byte* last = buffer.data() + buffer.size();
+    for (int trial = 0; trial != 200; ++trial) {
+        auto A = trial % 2 ? draw_large_interval_union<double>(eng, trial) : draw_small_interval_unions(eng, 1)[0];
+        auto [end, ec] = libp::write_binary(first, last, A);
+        BOOST_TEST((ec == std::errc()));
+        BOOST_TEST(std::size_t(end - first) == libp::binary_size(A));
+        for (bool trusted : {false, true}) {
+            libp::IntervalUnion<double> B;
+            auto [read_end, read_ec] = libp::read_binary(first, static_cast<const std::byte*>(end), B, trusted);
+            BOOST_TEST((read_ec == std::errc())); BOOST_TEST(read_end == end);
+            BOOST_TEST(B == A);
+        }
+
+        // Across boundary types, and cut short.
+        libp::IntervalUnion<float> F;
+        libp::read_binary(first, static_cast<const std::byte*>(end), F, true);
+        BOOST_TEST(F == libp::IntervalUnion<float>(A));
+        auto [float_end, float_ec] = libp::write_binary(first, last, F);
+        libp::IntervalUnion<double> D;
+        libp::read_binary(first, static_cast<const std::byte*>(float_end), D);
+        BOOST_TEST(D == libp::IntervalUnion<double>(F));
+        auto [short_end, short_ec] = libp::read_binary(first, static_cast<const std::byte*>(float_end) - 1, D);
+        BOOST_TEST((short_ec == std::errc::invalid_argument)); BOOST_TEST(short_end == first);
+        BOOST_TEST(D == libp::IntervalUnion<double>(F));
+        BOOST_TEST((libp::write_binary(first, first + libp::binary_size(A) - 1, A).ec == std::errc::value_too_large));
+    }
+
+    // NaN and empty unions, and intervals that are not canonical, which untrusted reads repair.
+    libp::IntervalUnion<double> B;
+    auto end = libp::write_binary(first, last, libp::IntervalUnion<double>::nan()).ptr;
+    BOOST_TEST(end - first == 16);
+    libp::read_binary(first, static_cast<const std::byte*>(end), B); BOOST_TEST(B.isnan());
+    end = libp::write_binary(first, last, libp::IntervalUnion<double>()).ptr;
+    libp::read_binary(first, static_cast<const std::byte*>(end), B); BOOST_TEST(B.isempty());
+
+    libp::IntervalUnion<double> A{{'[',0.0,1.0,')'}, {'[',2.0,3.0,']'}};
+    end = libp::write_binary(first, last, A).ptr;
+    double values[4] = {2.0, 0.0, 3.0, 2.5};
+    std::memcpy(first + 16, values, sizeof(values));
+    libp::read_binary(first, static_cast<const std::byte*>(end), B);
+    BOOST_TEST((B == libp::IntervalUnion<double>{{'[',2.0,3.0,')'}, {'[',0.0,2.5,']'}}));
+    values[0] = std::numeric_limits<double>::quiet_NaN();
+    std::memcpy(first + 16, values, sizeof(values));
+    BOOST_TEST((libp::read_binary(first, static_cast<const std::byte*>(end), B).ec == std::errc::invalid_argument));
+    first[4] = std::byte(2);
+    BOOST_TEST((libp::read_binary(first, static_cast<const std::byte*>(end), B).ec == std::errc::not_supported));
+    first[0] = std::byte('X');
+    BOOST_TEST((libp::read_binary(first, static_cast<const std::byte*>(end), B).ec == std::errc::invalid_argument));
+}
+
+BOOST_AUTO_TEST_CASE(view_test) {
+    std::default_random_engine eng{std::random_device{}()};
+    std::uniform_real_distribution<double> x_dist(-12.0, 12.0);
+    std::vector<std::uint64_t> storage(1 << 13);
+    std::byte* first = reinterpret_cast<std::byte*>(storage.data());
+    std::byte* last = first + 8*storage.size();
+    for (int trial = 0; trial != 200; ++trial) {
+        auto unions = draw_small_interval_unions(eng, 2);
+        auto A = trial % 2 ? draw_large_interval_union<double>(eng, trial) : unions[0];
+        const auto& B = unions[1];
+        libp::IntervalUnionView<double> V(A), W(B);
+        BOOST_TEST(V.isempty() == A.isempty()); BOOST_TEST(V.isnan() == A.isnan());
+        BOOST_TEST(std::equal(V.cbegin(), V.cend(), A.cbegin(), A.cend()) == !A.isnan());
+        for (int k = 0; k != 20; ++k) {
+            double x = x_dist(eng);
+            BOOST_TEST(V(x) == A(x));
+        }
+        BOOST_TEST((V && W) == (A && B)); BOOST_TEST((V && B) == (A && B)); BOOST_TEST((A && W) == (A && B));
+        BOOST_TEST((V || W) == (A || B)); BOOST_TEST((V || B) == (A || B)); BOOST_TEST((A || W) == (A || B));
+        BOOST_TEST((V - W) == (A - B)); BOOST_TEST((V - B) == (A - B)); BOOST_TEST((A - W) == (A - B));
+        BOOST_TEST(V.inv() == A.inv()); BOOST_TEST(V.inv(true) == A.inv(true)); BOOST_TEST(!V == !A);
+        BOOST_TEST(((V && W).isnan() == (A.isnan() || B.isnan())));
+
+        // Over the bytes of write_binary, checked and trusted.
+        auto end = static_cast<const std::byte*>(libp::write_binary(first, last, A).ptr);
+        for (bool trusted : {false, true}) {
+            libp::IntervalUnionView<double> U;
+            auto [view_end, ec] = libp::view_binary(first, end, U, trusted);
+            BOOST_TEST((ec == std::errc())); BOOST_TEST(view_end == end);
+            BOOST_TEST(U.isnan() == A.isnan());
+            BOOST_TEST((U || W) == (A || B));
+        }
+    }
+
+    // Files that cannot be viewed as they stand, and unions that are not canonical.
+    libp::IntervalUnion<double> A{{'[',0.0,1.0,')'}, {'[',2.0,3.0,']'}};
+    libp::IntervalUnionView<double> U;
+    auto end = static_cast<const std::byte*>(libp::write_binary(first, last, libp::IntervalUnion<float>(A)).ptr);
+    BOOST_TEST((libp::view_binary(first, end, U).ec == std::errc::not_supported));
+    end = static_cast<const std::byte*>(libp::write_binary(first + 4, last, A).ptr);
+    BOOST_TEST((libp::view_binary(first + 4, end, U).ec == std::errc::not_supported));
+    end = static_cast<const std::byte*>(libp::write_binary(first, last, A).ptr);
+    double values[4] = {0.0, 1.0, 1.0, 3.0};
+    std::memcpy(first + 16, values, sizeof(values));
+    BOOST_TEST((libp::view_binary(first, end, U).ec == std::errc::invalid_argument));
+    BOOST_TEST((libp::view_binary(first, end, U, true).ec == std::errc()));
+    values[1] = 2.0;
+    std::memcpy(first + 16, values, sizeof(values));
+    BOOST_TEST((libp::view_binary(first, end, U).ec == std::errc()));
+    BOOST_TEST((libp::IntervalUnion<double>(U.cbegin(), U.cend()) == A));
+
+    #ifdef LIBP_HAS_MMAP
+        auto path = std::filesystem::temp_directory_path() / "libp_view_test.bin";
+        {
+            std::ofstream file(path, std::ios::binary);
+            file.write(reinterpret_cast<const char*>(first), end - first);
+        }
+        {
+            libp::MappedFile mapped(path);
+            BOOST_TEST(mapped.size() == std::size_t(end - first));
+            BOOST_TEST((libp::view_binary(mapped.data(), mapped.data() + mapped.size(), U).ec == std::errc()));
+            BOOST_TEST((U && A) == A);
+            libp::MappedFile moved(std::move(mapped));
+            BOOST_TEST(U(2.5) == 1.0); BOOST_TEST(U(1.0) == 0.0);
+        }
+        std::filesystem::remove(path);
+        BOOST_CHECK_THROW(libp::MappedFile{path}, std::system_error);
+    #endif
+}
+
+BOOST_AUTO_TEST_CASE(stream_test) {
+    // Compared against the in-memory operations.
+    std::default_random_engine eng{std::random_device{}()};
+    auto intervals_of = [](const auto& A) { return std::ranges::subrange(A.cbegin(), A.cend()); };
+    auto collect = [](auto&& write) {
+        std::vector<libp::Interval<double>> out;
+        write(std::back_inserter(out));
+        return libp::IntervalUnion<double>(out.begin(), out.end());
+    };
+    for (int trial = 0; trial != 200; ++trial) {
+        auto unions = draw_small_interval_unions(eng, 2);
+        const auto& A = unions[0];
+        const auto& B = unions[1];
+        BOOST_TEST(collect([&](auto out) { libp::stream_intersection(intervals_of(A), intervals_of(B), out); }) == (A && B));
+        BOOST_TEST(collect([&](auto out) { libp::stream_union(intervals_of(A), intervals_of(B), out); }) == (A || B));
+        BOOST_TEST(collect([&](auto out) { libp::stream_difference(intervals_of(A), intervals_of(B), out); }) == (A - B));
+        for (bool extended : {false, true}) {
+            BOOST_TEST(collect([&](auto out) { libp::stream_complement(intervals_of(A), out, extended); }) == A.inv(extended));
+        }
+    }
+    auto nan = libp::IntervalUnion<double>::nan();
+    auto A = draw_large_interval_union<double>(eng, 100);
+    BOOST_TEST(collect([&](auto out) { libp::stream_union(intervals_of(A), intervals_of(nan), out); }).isnan());
+    BOOST_TEST(collect([&](auto out) { libp::stream_complement(intervals_of(nan), out); }).isnan());
+
+    // From streams of text.
+    std::stringstream text;
+    text.precision(17);
+    for (auto iter = A.cbegin(); iter != A.cend(); ++iter) { text << *iter << ' '; }
+    auto B = draw_large_interval_union<double>(eng, 100);
+    BOOST_TEST(collect([&](auto out) { libp::stream_intersection(std::views::istream<libp::Interval<double>>(text), intervals_of(B), out); }) == (A && B));
+}
+
+BOOST_AUTO_TEST_CASE(external_canonicalise_test) {
+    std::default_random_engine eng{std::random_device{}()};
+    std::uniform_real_distribution<double> boundary_dist(-100.0, 100.0);
+    std::bernoulli_distribution closed_bracket_dist(0.5);
+    for (std::size_t run_intervals : {1, 7, 1000}) {
+        std::vector<libp::Interval<double>> intervals;
+        std::stringstream in;
+        in.precision(17);
+        for (int i = 0; i != 500; ++i) {
+            intervals.emplace_back(closed_bracket_dist(eng) ? '[' : '(', boundary_dist(eng), boundary_dist(eng), closed_bracket_dist(eng) ? ']' : ')');
+            in << intervals.back() << (i % 3 ? " " : "\n");
+        }
+        std::stringstream out;
+        BOOST_TEST((libp::external_canonicalise<double>(in, out, run_intervals) == std::errc()));
+        libp::IntervalUnion<double> A;
+        out >> A;
+        BOOST_TEST(A == libp::IntervalUnion<double>(intervals.begin(), intervals.end()));
+    }
+
+    std::stringstream nan_in("[0,1] (nan,nan] [2,3]"), nan_out;
+    BOOST_TEST((libp::external_canonicalise<double>(nan_in, nan_out, 1) == std::errc()));
+    BOOST_TEST(nan_out.str() == "(nan,nan]\n");
+    std::stringstream bad_in("[0,1] [2,x]"), bad_out;
+    BOOST_TEST((libp::external_canonicalise<double>(bad_in, bad_out) == std::errc::invalid_argument));
+
+    // The text operator<< writes for unions, one union to a line, reads as the union of them all.
+    std::vector<libp::IntervalUnion<double>> unions = {{libp::Interval<double>('[',0,1,')'), libp::Interval<double>('[',2,3,')')}, {}, {libp::Interval<double>('(',2.5,6,']')}};
+    std::stringstream union_in, union_out;
+    union_in.precision(17);
+    for (const auto& U : unions) { union_in << U << '\n'; }
+    BOOST_TEST((libp::external_canonicalise<double>(union_in, union_out, 1) == std::errc()));
+    libp::IntervalUnion<double> U;
+    union_out >> U;
+    BOOST_TEST(U == (unions[0] || unions[1] || unions[2]));
+
+    // An empty union, from no intervals or only empty ones, is written as to_chars writes it.
+    for (std::size_t run_intervals : {1, 1000}) {
+        for (std::string text : {"", " \n", "(0,0);\n(0,0);", "(1,1) [2,2)"}) {
+            std::stringstream empty_in(text), empty_out;
+            BOOST_TEST((libp::external_canonicalise<double>(empty_in, empty_out, run_intervals) == std::errc()));
+            BOOST_TEST(empty_out.str() == "(0,0);\n");
+            std::string written = empty_out.str();
+            libp::IntervalUnion<double> E('[',0.0,1.0,']');
+            BOOST_TEST((libp::from_chars(written.data(), written.data() + written.size(), E).ec == std::errc()));
+            BOOST_TEST(E.isempty());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(integral_boundary_test) {
+    // Integer unions compared against the same unions with double boundaries, which hold small integers
+    // exactly, and discrete unions compared against their members among the integers.
+    std::default_random_engine eng{std::random_device{}()};
+    std::uniform_int_distribution<int> boundary_dist(-10, 10);
+    std::bernoulli_distribution closed_bracket_dist(0.5);
+    auto draw = [&]() {
+        std::vector<std::tuple<char, int, int, char>> intervals;
+        for (int i = std::uniform_int_distribution<int>(0, 4)(eng); i != 0; --i) {
+            intervals.emplace_back(closed_bracket_dist(eng) ? '[' : '(', boundary_dist(eng), boundary_dist(eng), closed_bracket_dist(eng) ? ']' : ')');
+        }
+        return intervals;
+    };
+    auto make = [](const auto& intervals, auto boundary) {
+        using Boundary = decltype(boundary);
+        std::vector<libp::Interval<Boundary>> out;
+        for (auto [l, a, b, r] : intervals) { out.emplace_back(l, Boundary(a), Boundary(b), r); }
+        return libp::IntervalUnion<Boundary>(out.begin(), out.end());
+    };
+    for (int trial = 0; trial != 200; ++trial) {
+        auto a = draw();
+        auto b = draw();
+        auto A = make(a, std::int64_t()), B = make(b, std::int64_t());
+        auto C = make(a, 0.0), D = make(b, 0.0);
+        BOOST_TEST(libp::IntervalUnion<double>(A && B) == (C && D));
+        BOOST_TEST(libp::IntervalUnion<double>(A || B) == (C || D));
+        BOOST_TEST(libp::IntervalUnion<double>(A - B) == (C - D));
+        BOOST_TEST(libp::IntervalUnion<double>(A.inv()) == C.inv());
+        BOOST_TEST(libp::IntervalUnion<double>(!A) == !C);
+
+        auto E = make(a, libp::Discrete<std::int16_t>()), F = make(b, libp::Discrete<std::int16_t>());
+        for (std::int16_t x = -12; x != 13; ++x) {
+            bool e = false, f = false;
+            for (auto [l, lo, hi, r] : a) { e = e || libp::Interval<double>(l, lo, hi, r)(x); }
+            for (auto [l, lo, hi, r] : b) { f = f || libp::Interval<double>(l, lo, hi, r)(x); }
+            BOOST_TEST(bool(E(x)) == e);
+            BOOST_TEST(bool((E && F)(x)) == (e && f));
+            BOOST_TEST(bool((E || F)(x)) == (e || f));
+            BOOST_TEST(bool((E - F)(x)) == (e && !f));
+            BOOST_TEST(bool(E.inv()(x)) == !e);
+        }
+        auto G = E || F;
+        BOOST_TEST(((libp::lazy(E) - F).eval() == E - F));
+        for (auto iter = G.cbegin(); iter != G.cend(); ++iter) {
+            BOOST_TEST((iter->left_bracket() == '[' && iter->right_bracket() == ')'));
+        }
+    }
+
+    using Discrete = libp::IntervalUnion<libp::Discrete<std::int16_t>>;
+    using Short = libp::IntervalUnion<std::int16_t>;
+    BOOST_TEST((Discrete{{'[',1,2,']'}, {'[',3,4,']'}} == Discrete('[', 1, 4, ']')));
+    BOOST_TEST((Discrete('(', 1, 2, ')').isempty()));
+    BOOST_TEST((Discrete('(', 1, 3, ')') == Discrete('[', 2, 2, ']')));
+    BOOST_TEST((Short{{'[',1,2,']'}, {'[',3,4,']'}} != Short('[', 1, 4, ']')));
+    BOOST_TEST((Discrete(Short{{'[',1,2,']'}, {'[',3,4,']'}}) == Discrete('[', 1, 4, ']')));
+    BOOST_TEST((Discrete(libp::Interval<std::int16_t>('(', 1, 2, ')')).isempty()));
+    BOOST_TEST((Short(Discrete('[', 1, 2, ']')) == Short('[', 1, 3, ')')));
+
+    using Unsigned = libp::IntervalUnion<std::uint32_t>;
+    const auto inf_u = libp::boundary_traits<std::uint32_t>::infinity();
+    BOOST_TEST(Unsigned::universal()(0u)); BOOST_TEST(Unsigned::universal(true)(0u));
+    BOOST_TEST((Unsigned('[', 5u, 7u, ')').inv(true) == Unsigned{{'[',0u,5u,')'}, {'[',7u,inf_u,']'}}));
+    BOOST_TEST(((!Unsigned('[', 5u, 10u, ')')) == Unsigned{{'[',0u,5u,')'}, {'[',10u,inf_u,')'}}));
+    BOOST_TEST((Unsigned('(', 0u, 5u, ')').inv() == Unsigned{{'[',0u,0u,']'}, {'[',5u,inf_u,')'}}));
+    BOOST_TEST(((!Unsigned('[', 0u, 5u, ')')) == Unsigned('[', 5u, inf_u, ')')));
+    BOOST_TEST((libp::IntervalUnion<std::int64_t>(Unsigned('[', 0u, 5u, ')')) == libp::IntervalUnion<std::int64_t>('[', 0, 5, ')')));
+    BOOST_TEST(((!libp::lazy(Unsigned('(', 0u, 5u, ']'))).eval() == !Unsigned('(', 0u, 5u, ']')));
+    BOOST_TEST(libp::IntervalUnion<std::int64_t>::nan().isnan());
+    BOOST_TEST(libp::IntervalUnion<double>(libp::IntervalUnion<std::int64_t>::universal(true)) == libp::IntervalUnion<double>::universal(true));
+    BOOST_TEST(sizeof(libp::Interval<std::uint32_t>) < sizeof(libp::Interval<double>));
+
+    // Lazy and streamed results keep the infinities when written to another boundary type, and sentinel
+    // types combine with others once converted, as for the eager operators.
+    using Int32 = libp::IntervalUnion<std::int32_t>;
+    using Int64 = libp::IntervalUnion<std::int64_t>;
+    using Double = libp::IntervalUnion<double>;
+    const auto inf32 = libp::boundary_traits<std::int32_t>::infinity();
+    const Int32 H('[', 0, inf32, ')'), I{{'[', -3, 1, ')'}, {'(', 4, 6, ']'}};
+    const Int64 J('[', -5, 5, ']');
+    Int64 HI = libp::lazy(H) || libp::lazy(I);
+    BOOST_TEST(HI == Int64(H || I));
+    BOOST_TEST(HI.cbegin()->right_value() == libp::boundary_traits<std::int64_t>::infinity());
+    Double HI_inv = (libp::lazy(H) || libp::lazy(I)).inv(true);
+    BOOST_TEST(HI_inv == Double((H || I).inv(true)));
+    BOOST_TEST((HI_inv == Double{{'[', -INFINITY, -3.0, ')'}, {'[', INFINITY, INFINITY, ']'}}));
+    BOOST_TEST(((libp::lazy(Int64(H)) || libp::lazy(J)) && Int64(I)).eval() == ((Int64(H) || J) && Int64(I)));
+
+    auto intervals_of = [](const auto& A) { return std::ranges::subrange(A.cbegin(), A.cend()); };
+    auto as_int64 = std::views::transform([](const libp::Interval<std::int32_t>& K) { return libp::Interval<std::int64_t>(K); });
+    std::vector<libp::Interval<std::int64_t>> streamed;
+    libp::stream_union(intervals_of(H) | as_int64, intervals_of(J), std::back_inserter(streamed));
+    BOOST_TEST(Int64(streamed.begin(), streamed.end()) == (Int64(H) || J));
+    std::vector<libp::Interval<double>> streamed_double;
+    libp::stream_complement(intervals_of(H), std::back_inserter(streamed_double), true);
+    BOOST_TEST((Double(streamed_double.begin(), streamed_double.end()) == Double{{'[', -INFINITY, 0.0, ')'}, {'[', INFINITY, INFINITY, ']'}}));
+}
+
+BOOST_AUTO_TEST_CASE(constexpr_test) {
+    // Set algebra evaluated at compile time, checked against the same expressions at run time, and a
+    // result frozen into a constexpr variable.
+    using libp::IntervalUnion;
+    constexpr auto make_A = []() { return IntervalUnion<double>{{'[', 3.0, 4.0, ')'}, {'(', 0.0, 1.0, ']'}, {'[', 0.5, 2.0, ')'}}; };
+    constexpr auto make_B = []() { return IntervalUnion<double>('(', 1.5, 3.5, ']'); };
+
+    static_assert((make_A() && make_B()) == IntervalUnion<double>{{'(', 1.5, 2.0, ')'}, {'[', 3.0, 3.5, ']'}});
+    static_assert((make_A() || make_B()) == IntervalUnion<double>('(', 0.0, 4.0, ')'));
+    static_assert((make_A() - make_B()) == IntervalUnion<double>{{'(', 0.0, 1.5, ']'}, {'(', 3.5, 4.0, ')'}});
+    static_assert(make_A().inv() == IntervalUnion<double>{{'(', -INFINITY, 0.0, ']'}, {'[', 2.0, 3.0, ')'}, {'[', 4.0, INFINITY, ')'}});
+    static_assert(make_A()(0.5) && !make_A()(2.0) && make_A()(3.0));
+    static_assert(IntervalUnion<double>::nan().isnan() && (make_A() && IntervalUnion<double>::nan()).isnan());
+    static_assert(IntervalUnion<int>{{'[', 1, 2, ']'}, {'[', 2, 5, ')'}} == IntervalUnion<int>('[', 1, 5, ')'));
+
+    constexpr auto F = libp::freeze<[]() { return (IntervalUnion<double>('[', 3.0, 4.0, ')') || IntervalUnion<double>('(', 0.0, 1.0, ']')) - IntervalUnion<double>('(', 0.5, 3.5, ')'); }>();
+    static_assert(F.size() == 2 && !F.isnan());
+    static_assert(F(0.5) && !F(1.0) && F(3.5) && !F(4.0));
+    static_assert(libp::freeze<[]() { return IntervalUnion<double>::nan(); }>().isnan());
+    static_assert(libp::freeze<[]() { return IntervalUnion<double>(); }>().size() == 0);
+
+    IntervalUnion<double> A = make_A(), B = make_B();
+    BOOST_CHECK((A && B) == (make_A() && make_B()));
+    BOOST_CHECK((IntervalUnion<double>(F) == IntervalUnion<double>{{'(', 0.0, 0.5, ']'}, {'[', 3.5, 4.0, ')'}}));
+    BOOST_CHECK((F.view() || A) == (IntervalUnion<double>(F) || A));
+}
+
+BOOST_AUTO_TEST_CASE(static_interval_union_test) {
+    // Compared against IntervalUnion, with a capacity small enough that the random unions often
+    // overflow it. The unions cannot allocate, so any attempt would throw.
+    using Error = libp::StaticIntervalUnion<double, 3>;
+    using Saturate = libp::StaticIntervalUnion<double, 3, libp::CapacityPolicy::saturate>;
+    using libp::IntervalUnion;
+    std::default_random_engine eng{std::random_device{}()};
+    std::uniform_real_distribution<double> x_dist(-1.0, 13.0);
+    auto size_of = [](const IntervalUnion<double>& A) { return std::size_t(std::distance(A.cbegin(), A.cend())); };
+    auto check = [&](const auto& op, const IntervalUnion<double>& A, const IntervalUnion<double>& B) {
+        auto expected = op(A, B);
+        Error EA(A), EB(B);
+        Saturate SA(A), SB(B);
+        bool inputs_fit = size_of(A) <= 3 && size_of(B) <= 3;
+        BOOST_TEST(EA.overflowed() == (size_of(A) > 3)); BOOST_TEST(EA.isnan() == EA.overflowed());
+        BOOST_TEST(SA.overflowed() == (size_of(A) > 3)); BOOST_TEST(SA.size() == std::min<std::size_t>(size_of(A), 3));
+        BOOST_TEST(A <= IntervalUnion<double>(SA));
+        auto E = op(EA, EB);
+        auto S = op(SA, SB);
+        if (inputs_fit && size_of(expected) <= 3) {
+            BOOST_TEST(!E.overflowed()); BOOST_TEST(!S.overflowed());
+            BOOST_TEST(IntervalUnion<double>(E) == expected); BOOST_TEST(IntervalUnion<double>(S) == expected);
+            BOOST_TEST((E == Error(expected)));
+        } else {
+            BOOST_TEST(E.isnan()); BOOST_TEST(E.overflowed()); BOOST_TEST(S.overflowed());
+            if (inputs_fit) { BOOST_TEST(expected < IntervalUnion<double>(S)); BOOST_TEST(S.size() == 3); }
+        }
+        for (int k = 0; k != 10; ++k) {
+            double x = x_dist(eng);
+            if (!E.isnan()) { BOOST_TEST(E(x) == expected(x)); }
+            BOOST_TEST(S(x) >= expected(x) * inputs_fit);
+        }
+    };
+    for (int trial = 0; trial != 300; ++trial) {
+        auto unions = draw_small_interval_unions(eng, 2);
+        const auto& A = unions[0];
+        const auto& B = unions[1];
+        check([](const auto& X, const auto& Y) { return X && Y; }, A, B);
+        check([](const auto& X, const auto& Y) { return X || Y; }, A, B);
+        check([](const auto& X, const auto& Y) { return X - Y; }, A, B);
+        check([](const auto& X, const auto&) { return X.inv(); }, A, A);
+        check([](const auto& X, const auto&) { return !X; }, A, A);
+        if (size_of(A) <= 3 && size_of(B) <= 3) {
+            Error EA(A), EB(B);
+            BOOST_TEST((EA <= EB) == (A <= B)); BOOST_TEST(isdisjoint(EA, EB) == isdisjoint(A, B));
+            BOOST_TEST((EA != EB) == (A != B));
+            EA |= EB;
+            if (size_of(A || B) <= 3) { BOOST_TEST(IntervalUnion<double>(EA) == (A || B)); } else { BOOST_TEST(EA.isnan()); }
+        }
+    }
+
+    // The operations a FunctionSpace domain needs, and construction from intervals in any order.
+    BOOST_TEST(Error::empty().isempty()); BOOST_TEST(Error::nan().isnan()); BOOST_TEST(!Error::nan().overflowed());
+    BOOST_TEST(IntervalUnion<double>(Error::universal(true)) == IntervalUnion<double>::universal(true));
+    BOOST_TEST(IntervalUnion<double>(!Error::empty()) == IntervalUnion<double>::universal());
+    Error C = {{'[',5.0,6.0,')'}, {'(',0.0,1.0,')'}, {'[',1.0,2.0,']'}, {'(',3.0,4.0,')'}};
+    BOOST_TEST(IntervalUnion<double>(C) == (IntervalUnion<double>{{'[',5.0,6.0,')'}, {'(',0.0,2.0,']'}, {'(',3.0,4.0,')'}}));
+    Error D = {{'[',0.0,1.0,']'}, {'[',2.0,3.0,']'}, {'[',4.0,5.0,']'}, {'[',6.0,7.0,']'}};
+    BOOST_TEST(D.isnan()); BOOST_TEST(D.overflowed()); BOOST_TEST((D || C).overflowed());
+    Saturate E = {{'[',0.0,1.0,']'}, {'[',2.0,3.0,']'}, {'[',4.0,5.0,']'}, {'[',6.0,7.0,']'}};
+    BOOST_TEST(IntervalUnion<double>(E) == (IntervalUnion<double>{{'[',0.0,1.0,']'}, {'[',2.0,3.0,']'}, {'[',4.0,7.0,']'}}));
+    static_assert((Error('[', 0.0, 2.0, ']') - Error('(', 1.0, 3.0, ')'))(1.0));
+}
+
+BOOST_AUTO_TEST_CASE(interval_set_test) {
+    // Random inserts and erases, compared after each against the same changes made with || and - on an
+    // IntervalUnion. Boundaries are drawn from a few values so that brackets often meet.
+    std::default_random_engine eng{std::random_device{}()};
+    std::uniform_int_distribution<int> boundary_dist(0, 20);
+    std::bernoulli_distribution closed_bracket_dist(0.5);
+    std::uniform_real_distribution<double> x_dist(-1.0, 21.0);
+    for (int trial = 0; trial != 20; ++trial) {
+        libp::IntervalSet<double> S;
+        libp::IntervalUnion<double> A;
+        for (int step = 0; step != 200; ++step) {
+            libp::Interval<double> I(
+                closed_bracket_dist(eng) ? '[' : '(', double(boundary_dist(eng)), double(boundary_dist(eng)), closed_bracket_dist(eng) ? ']' : ')'
+            );
+            if (step % 3 == 2) {
+                S.erase(I); A = A - libp::IntervalUnion<double>(I);
+            } else {
+                S.insert(I); A = A || libp::IntervalUnion<double>(I);
+            }
+            BOOST_TEST(libp::IntervalUnion<double>(S) == A);
+            BOOST_TEST(S.size() == std::size_t(std::distance(A.cbegin(), A.cend())));
+            BOOST_TEST(std::equal(S.cbegin(), S.cend(), A.cbegin(), A.cend()));
+            for (int k = 0; k != 5; ++k) {
+                double x = k < 2 ? double(boundary_dist(eng)) : x_dist(eng);
+                BOOST_TEST(S(x) == A(x));
+            }
+        }
+        BOOST_TEST((libp::IntervalSet<double>(A) == S));
+    }
+
+    libp::IntervalSet<double> S = {{'[',0.0,1.0,')'}, {'[',2.0,3.0,']'}, {'(',1.0,2.0,')'}};
+    BOOST_TEST(S.size() == 2);
+    S.insert('[', 1.0, 1.0, ']');
+    BOOST_TEST(S.size() == 1); BOOST_TEST(S(1.0) == 1.0);
+    S.erase('(', 1.0, 2.0, ']');
+    BOOST_TEST((libp::IntervalUnion<double>(S) == libp::IntervalUnion<double>{{'[',0.0,1.0,']'}, {'(',2.0,3.0,']'}}));
+    S.insert(libp::Interval<double>::nan());
+    BOOST_TEST(S.isnan()); BOOST_TEST(libp::IntervalUnion<double>(S).isnan()); BOOST_TEST(!(S == S));
+    S.clear();
+    BOOST_TEST(S.isempty());
+    BOOST_TEST(libp::IntervalSet<double>(libp::IntervalUnion<double>::nan()).isnan());
+}
+
+BOOST_AUTO_TEST_CASE(uniform_sampler_test) {
+    // The share of draws in each interval against its share of the length, and the degenerate unions.
+    std::default_random_engine eng{std::random_device{}()};
+    libp::IntervalUnion<double> A{{'(',0.0,1.0,')'}, {'[',2.0,4.0,']'}, {'[',5.0,5.0,']'}, {'[',6.0,7.0,')'}};
+    libp::UniformSampler<double> sampler(A);
+    BOOST_TEST(sampler.measure() == 4.0);
+    std::vector<double> xs(40000);
+    sampler(eng, xs);
+    std::size_t counts[3] = {0, 0, 0};
+    for (double x : xs) {
+        BOOST_TEST(A(x) == 1.0);
+        BOOST_TEST(x != 5.0);
+        counts[x < 1.0 ? 0 : x <= 4.0 ? 1 : 2]++;
+    }
+    BOOST_TEST(std::abs(counts[0]/40000.0 - 0.25) < 0.02);
+    BOOST_TEST(std::abs(counts[1]/40000.0 - 0.5) < 0.02);
+    BOOST_TEST(std::abs(counts[2]/40000.0 - 0.25) < 0.02);
+
+    // Batches are the same draws as one at a time.
+    auto eng_copy = eng;
+    sampler(eng, std::span(xs).first(100));
+    for (std::size_t i = 0; i != 100; ++i) { BOOST_TEST(xs[i] == sampler(eng_copy)); }
+
+    // Points only are drawn with equal probability, and every draw from a union with no uniform
+    // distribution is NaN.
+    libp::UniformSampler<double> points(libp::IntervalUnion<double>{{'[',1.0,1.0,']'}, {'[',3.0,3.0,']'}});
+    BOOST_TEST(points.measure() == 0.0);
+    std::size_t ones = 0;
+    for (int i = 0; i != 10000; ++i) {
+        double x = points(eng);
+        BOOST_TEST((x == 1.0 || x == 3.0));
+        ones += x == 1.0;
+    }
+    BOOST_TEST(std::abs(ones/10000.0 - 0.5) < 0.05);
+    for (const auto& B : {libp::IntervalUnion<double>(), libp::IntervalUnion<double>::nan(), libp::IntervalUnion<double>('[',0.0,INFINITY,')')}) {
+        libp::UniformSampler<double> degenerate(B);
+        BOOST_TEST(std::isnan(degenerate(eng)));
+        BOOST_TEST((degenerate.measure() == 0.0) == B.isempty());
+        BOOST_TEST(std::isnan(degenerate.measure()) == B.isnan());
+    }
+    double next = std::nextafter(1.0, 2.0);
+    libp::UniformSampler<double> ulp(libp::IntervalUnion<double>{{'(',1.0,next,')'}, {'[',2.0,2.0,']'}, {'(',next,std::nextafter(next, 2.0),']'}});
+    for (int i = 0; i != 100; ++i) { BOOST_TEST(ulp(eng) == std::nextafter(next, 2.0)); }
+
+    // A bounded union whose length overflows still has its uniform distribution.
+    const double big = std::numeric_limits<double>::max();
+    libp::IntervalUnion<double> W{{'[',-big,-big/2,']'}, {'[',0.0,big,']'}};
+    libp::UniformSampler<double> wide(W);
+    BOOST_TEST(std::isinf(wide.measure()));
+    int below = 0;
+    for (int i = 0; i != 3000; ++i) {
+        double x = wide(eng);
+        BOOST_TEST(W(x));
+        below += x < 0;
+    }
+    BOOST_TEST(std::abs(below - 1000) < 150);
+}
+
+BOOST_AUTO_TEST_CASE(var_interval_union_test) {
+    // The values of each result against the same operation on doubles, the handles of each result
+    // against the operand boundaries they must have come from, and the gradient of the measure.
+    using stan::math::var;
+    std::default_random_engine eng{std::random_device{}()};
+    auto to_var = [](const libp::IntervalUnion<double>& A) {
+        std::vector<libp::Interval<var>> intervals;
+        for (auto iter = A.cbegin(); iter != A.cend(); ++iter) {
+            intervals.emplace_back(iter->left_bracket(), var(iter->left_value()), var(iter->right_value()), iter->right_bracket());
+        }
+        return libp::IntervalUnion<var>(intervals.begin(), intervals.end());
+    };
+    auto handles_of = [](const libp::IntervalUnion<var>& A) {
+        std::vector<stan::math::vari*> handles;
+        for (auto iter = A.cbegin(); iter != A.cend(); ++iter) {
+            handles.push_back(iter->left_value().vi_);
+            handles.push_back(iter->right_value().vi_);
+        }
+        return handles;
+    };
+    for (int trial = 0; trial != 100; ++trial) {
+        auto unions = draw_small_interval_unions(eng, 2);
+        const auto& A = unions[0];
+        const auto& B = unions[1];
+        auto A_var = to_var(A), B_var = to_var(B);
+        libp::VarIntervalUnion V(A_var), W(B_var);
+        BOOST_TEST(V.value() == A);
+        auto operand_handles = handles_of(A_var);
+        for (auto handle : handles_of(B_var)) { operand_handles.push_back(handle); }
+        auto check = [&](const libp::VarIntervalUnion& R, const libp::IntervalUnion<double>& expected) {
+            BOOST_TEST(R.value() == expected);
+            auto R_var = libp::IntervalUnion<var>(R);
+            for (auto iter = R_var.cbegin(); iter != R_var.cend(); ++iter) {
+                for (const auto& x : {iter->left_value(), iter->right_value()}) {
+                    bool from_operand = std::find(operand_handles.begin(), operand_handles.end(), x.vi_) != operand_handles.end();
+                    BOOST_TEST((from_operand || std::isinf(x.val())));
+                }
+            }
+        };
+        check(V && W, A && B);
+        check(V || W, A || B);
+        check(V - W, A - B);
+        check(V.inv(), A.inv());
+        check(!V, !A);
+        BOOST_TEST((V == W) == (A == B));
+        BOOST_TEST(V(6.0) == A(6.0));
+
+        // Each boundary of the result gets -1 from each time it is a left boundary and 1 from each
+        // time it is a right one.
+        auto R = V && W;
+        auto R_var = libp::IntervalUnion<var>(R);
+        var M = R.measure();
+        BOOST_TEST(M.val() == (R.isempty() ? 0.0 : std::accumulate(R_var.cbegin(), R_var.cend(), 0.0, [](double total, const auto& I) { return total + I.right_value().val() - I.left_value().val(); })));
+        M.grad();
+        for (auto handle : operand_handles) {
+            double expected = 0;
+            for (auto iter = R_var.cbegin(); iter != R_var.cend(); ++iter) {
+                expected += (iter->right_value().vi_ == handle) - (iter->left_value().vi_ == handle);
+            }
+            BOOST_TEST(handle->adj_ == expected);
+        }
+        stan::math::recover_memory();
+    }
+    BOOST_TEST(libp::VarIntervalUnion(libp::IntervalUnion<var>::nan()).isnan());
+    BOOST_TEST(libp::VarIntervalUnion::universal().inv().isempty());
+}
+
+BOOST_AUTO_TEST_CASE(cut_key_test) {
+    // Keys order as the cuts they encode, across signs, zeros and infinities.
+    std::default_random_engine eng{std::random_device{}()};
+    auto check = [&](auto zero) {
+        using T = decltype(zero);
+        const T inf = std::numeric_limits<T>::infinity();
+        std::vector<T> values = {-inf, T(-2.5), T(-1), -std::numeric_limits<T>::denorm_min(), T(-0.0), T(0), std::numeric_limits<T>::denorm_min(), T(1), T(3), inf};
+        std::uniform_real_distribution<T> value_dist(-4, 4);
+        for (int i = 0; i != 20; ++i) { values.push_back(value_dist(eng)); }
+        for (T s : values) {
+            for (T t : values) {
+                for (bool a : {false, true}) {
+                    for (bool b : {false, true}) {
+                        libp::detail::Cut<T> x{s, a}, y{t, b};
+                        BOOST_TEST((libp::detail::cut_key(s, a) < libp::detail::cut_key(t, b)) == (x < y));
+                        BOOST_TEST((libp::detail::cut_key(s, a) == libp::detail::cut_key(t, b)) == (x == y));
+                    }
+                }
+            }
+        }
+    };
+    check(0.0f);
+    if constexpr (libp::detail::cut_key_traits<double>::enabled) { check(0.0); }
+}